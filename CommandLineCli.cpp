@@ -49,7 +49,17 @@ std::map<std::string,uint32_t> parseExpertMode(std::string &expertMode) {
         if(pos2 != std::string::npos){
             auto key = flag.substr(0,pos2);
             auto value = flag.substr(pos2 + valueDelimiter.size(),std::string::npos);
-            flags[key] = static_cast<uint32_t>(std::stoul(value,nullptr,10));
+            //the labeler is given by name
+            if(key == "labeler") {
+                flags[key] = static_cast<uint32_t>(egt::parseLabeler(value));
+            }
+            //the mask compression is given by name
+            else if(key == "compression") {
+                flags[key] = static_cast<uint32_t>(egt::parseMaskCompression(value));
+            }
+            else {
+                flags[key] = static_cast<uint32_t>(std::stoul(value, nullptr, 10));
+            }
         }
         expertMode.erase(0, pos + flagDelimiter.length());
     }
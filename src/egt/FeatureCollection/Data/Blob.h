@@ -44,6 +44,8 @@
 #include <iostream>
 #include <FastImage/api/FastImage.h>
 #include <unordered_set>
+#include <vector>
+#include <algorithm>
 #include "Feature.h"
 
 /// \namespace fc FeatureCollection namespace
@@ -52,6 +54,14 @@ namespace egt {
 /// \brief Coordinate structure as a pair of int32_t for <row, col>
 using Coordinate = std::pair<int32_t, int32_t>;
 
+/// \brief Horizontal run of pixels on a row, from colStart to colEnd (excluded)
+struct RowRun {
+  int32_t
+      row,        ///< Run row
+      colStart,   ///< First col of the run
+      colEnd;     ///< Col after the last col of the run
+};
+
 
 /**
   * @class Blob Blob.h <FastImage/FeatureCollection/Data/Blob.h>
@@ -59,8 +69,8 @@ using Coordinate = std::pair<int32_t, int32_t>;
   * @brief Blob representing a part of a feature
   *
   * @details It is composed by a bounding box from the point (rowMin, rowMax) to
-  * (rowMAx, ColMax).The bounding box delimit a sparse matrix representing the
-  * pixels part of this blob. A blob has a specific id, called tag.
+  * (rowMAx, ColMax).The bounding box delimit a run-length encoded sparse matrix
+  * representing the pixels part of this blob. A blob has a specific id, called tag.
   **/
 class Blob {
  public:
@@ -114,11 +124,11 @@ class Blob {
     }
 
 
-    /// \brief Get sparse matrix structure
+  /// \brief Get the runs composing the blob, sorted by row and col, without overlaps
   /// \return Sparse matrix structure
-  std::unordered_map<int32_t, std::unordered_set<int32_t>>
-  &getRowCols() {
-    return _rowCols;
+  const std::vector<RowRun> &getRuns() {
+    sortRuns();
+    return _runs;
   }
   /// \brief Get minimum bounding box row
   /// \return Minimum bounding box row
@@ -140,6 +150,10 @@ class Blob {
   /// \return Number of pixels in a blob
   uint64_t getCount() const { return _count; }
 
+  /// \brief Get the sum of the original image intensities of the blob pixels
+  /// \return Sum of the blob pixel intensities
+  uint64_t getIntensitySum() const { return _intensitySum; }
+
   /// \brief Get blob parent, used by Union find
   /// \return Blob  parent
   Blob *getParent() const { return _parent; }
@@ -159,7 +173,17 @@ class Blob {
         if(_feature != nullptr) {
             return _feature->isImagePixelInBitMask(row, col);
         }
-        return (_rowCols.count(row) != 0) && (_rowCols[row].count(col) != 0);
+        sortRuns();
+        //find the last run starting at or before (row, col)
+        auto it = std::upper_bound(_runs.begin(), _runs.end(), Coordinate(row, col),
+                                   [](const Coordinate &c, const RowRun &run) {
+                                       return c.first < run.row || (c.first == run.row && c.second < run.colStart);
+                                   });
+        if (it == _runs.begin()) {
+          return false;
+        }
+        --it;
+        return it->row == row && col < it->colEnd;
     }
     return false;
   }
@@ -193,6 +217,10 @@ class Blob {
   /// \param count Pixel Count
   void setCount(uint64_t count) { _count = count; }
 
+  /// \brief Intensity sum setter
+  /// \param intensitySum Sum of the blob pixel intensities
+  void setIntensitySum(uint64_t intensitySum) { _intensitySum = intensitySum; }
+
   /// \brief Blob parent setter Used by Union find algorithm
   /// \param parent Blob parent
   void setParent(Blob *parent) { _parent = parent; }
@@ -218,6 +246,23 @@ class Blob {
 
   }
 
+  /// \brief Add a run of pixels to the blob and update blob metadata
+  /// \param row Run's row
+  /// \param colStart Run's first col
+  /// \param colEnd Col after the run's last col
+  void addRun(int32_t row, int32_t colStart, int32_t colEnd) {
+    if (row < _rowMin)
+      _rowMin = row;
+    if (colStart < _colMin)
+      _colMin = colStart;
+    if (row >= _rowMax)
+      _rowMax = row + 1;
+    if (colEnd > _colMax)
+      _colMax = colEnd;
+    _count += colEnd - colStart;
+    appendRun(row, colStart, colEnd);
+  }
+
   /// \brief Merge 2 blobs, and delete the unused one
   /// \param blob Blob to merge with the current
   /// \return The blob merged
@@ -245,15 +290,14 @@ class Blob {
         std::max(destination->getColMax(), toDelete->getColMax()));
 
     // Merge sparse matrix
-    for (auto &rowCol : toDelete->getRowCols()) {
-      for (auto col : rowCol.second) {
-        destination->addRowCol(rowCol.first, col);
-      }
+    for (auto &run : toDelete->_runs) {
+      destination->appendRun(run.row, run.colStart, run.colEnd);
     }
 
 
     // update pixel count
     destination->setCount(toDelete->getCount() + destination->getCount());
+    destination->setIntensitySum(toDelete->getIntensitySum() + destination->getIntensitySum());
 
     // Delete unused Blob
     delete (toDelete);
@@ -265,16 +309,10 @@ class Blob {
   void compactBlobDataIntoFeature() {
 
     uint32_t
-            idFeature = 0,
             rowMin = (uint32_t) this->getRowMin(),
             colMin = (uint32_t)this->getColMin(),
             rowMax = (uint32_t)this->getRowMax(),
-            colMax = (uint32_t)this->getColMax(),
-            ulRowL = 0,
-            ulColL = 0,
-            wordPosition = 0,
-            bitPositionInDecimal = 0,
-            absolutePosition = 0;
+            colMax = (uint32_t)this->getColMax();
 
     //TODO change coords to uint32_t?
     BoundingBox boundingBox(
@@ -285,72 +323,26 @@ class Blob {
 
     auto bitMask = new uint32_t[(uint32_t) ceil((boundingBox.getHeight() * boundingBox.getWidth()) / 32.)]();
 
-    // For every pixel in the bit mask
-    for (auto row = (uint32_t) rowMin; row < rowMax; ++row) {
-      for (auto col = (uint32_t) colMin; col < colMax; ++col) {
-        // Test if the pixel is in the current feature (using global coordinates)
-        if (this->isPixelinFeature(row, col)) {
-          // Add it to the bit mask
-          ulRowL = row - boundingBox.getUpperLeftRow(); //convert to local coordinates
-          ulColL = col - boundingBox.getUpperLeftCol();
-          absolutePosition = ulRowL * boundingBox.getWidth() + ulColL; //to 1D array coordinates
-          //optimization : right-shifting binary representation by 5 is equivalent to dividing by 32
-          wordPosition = absolutePosition >> (uint32_t) 5;
-          //left-shifting back previous result gives the 1D array coordinates of the word beginning
-          auto beginningOfWord = ((int32_t) (wordPosition << (uint32_t) 5));
-          //subtracting original value gives the remainder of the division by 32.
-          auto remainder = ((int32_t) absolutePosition - beginningOfWord);
-          //at which position in a binary representation the bit needs to be set?
-          bitPositionInDecimal = (uint32_t) abs(32 - remainder);
-          //create a 32bit word with this bit set to 1.
-          auto bitPositionInBinary = ((uint32_t) 1 << (bitPositionInDecimal - (uint32_t) 1));
-          //adding the bitPosition to the word
-          bitMask[wordPosition] = bitMask[wordPosition] | bitPositionInBinary;
-        }
-      }
+    // Each run is a contiguous sequence of bits in the bit mask
+    for (const auto &run : _runs) {
+      uint64_t absolutePosition = (uint64_t)(run.row - rowMin) * boundingBox.getWidth() + (run.colStart - colMin);
+      BitmaskAlgorithms::addRunToBitMask(bitMask, absolutePosition, (uint32_t)(run.colEnd - run.colStart));
     }
 
     _feature = new Feature(this->getTag(), boundingBox, bitMask);
-    _rowCols.clear();
+    _runs.clear();
+    _runs.shrink_to_fit();
   }
 
+  /// \brief OR the blob feature into a bitmask covering a larger bounding box
+  /// \param bitMask Destination bitmask
+  /// \param bb Destination bitmask bounding box, containing the blob bounding box
   void addToBitMask(uint32_t* bitMask, BoundingBox &bb) {
-
-    uint32_t
-      rowMin = (uint32_t) this->getRowMin(),
-      colMin = (uint32_t)this->getColMin(),
-      rowMax = (uint32_t)this->getRowMax(),
-      colMax = (uint32_t)this->getColMax(),
-      ulRowL = 0,
-      ulColL = 0,
-      wordPosition = 0,
-      bitPositionInDecimal = 0,
-      absolutePosition = 0;
-
-    // For every pixel in the bit mask
-    for (auto row = (uint32_t) rowMin; row < rowMax; ++row) {
-      for (auto col = (uint32_t) colMin; col < colMax; ++col) {
-        // Test if the pixel is in the current feature (using global coordinates)
-        if (this->getFeature()->isImagePixelInBitMask(row, col)) {
-          // Add it to the bit mask
-          ulRowL = row - bb.getUpperLeftRow(); //convert to local coordinates
-          ulColL = col - bb.getUpperLeftCol();
-          absolutePosition = ulRowL * bb.getWidth() + ulColL; //to 1D array coordinates
-          //optimization : right-shifting binary representation by 5 is equivalent to dividing by 32
-          wordPosition = absolutePosition >> (uint32_t) 5;
-          //left-shifting back previous result gives the 1D array coordinates of the word beginning
-          auto beginningOfWord = ((int32_t) (wordPosition << (uint32_t) 5));
-          //subtracting original value gives the remainder of the division by 32.
-          auto remainder = ((int32_t) absolutePosition - beginningOfWord);
-          //at which position in a binary representation the bit needs to be set?
-          bitPositionInDecimal = (uint32_t) abs(32 - remainder);
-          //create a 32bit word with this bit set to 1.
-          auto bitPositionInBinary = ((uint32_t) 1 << (bitPositionInDecimal - (uint32_t) 1));
-          //adding the bitPosition to the word
-          bitMask[wordPosition] = bitMask[wordPosition] | bitPositionInBinary;
-        }
-      }
-    }
+    const auto &featureBB = this->getFeature()->getBoundingBox();
+    BitmaskAlgorithms::orBitMask(this->getFeature()->getBitMask(), featureBB.getWidth(), featureBB.getHeight(),
+                                 bitMask, bb.getWidth(),
+                                 featureBB.getUpperLeftRow() - bb.getUpperLeftRow(),
+                                 featureBB.getUpperLeftCol() - bb.getUpperLeftCol());
   }
 
   //TODO remove, we will only  create Feature directly not modifying blobs
@@ -375,7 +367,47 @@ class Blob {
   /// \brief Add a pixel to the sparse matrix
   /// \param row Pixel row
   /// \param col Pixel col
-  void addRowCol(int32_t row, int32_t col) { _rowCols[row].insert(col); }
+  void addRowCol(int32_t row, int32_t col) { appendRun(row, col, col + 1); }
+
+  /// \brief Add a run to the sparse matrix, extending the last run when contiguous
+  /// \param row Run row
+  /// \param colStart Run first col
+  /// \param colEnd Col after the run last col
+  void appendRun(int32_t row, int32_t colStart, int32_t colEnd) {
+    if (!_runs.empty()) {
+      auto &last = _runs.back();
+      if (last.row == row && last.colEnd == colStart) {
+        last.colEnd = colEnd;
+        return;
+      }
+      if (row < last.row || (row == last.row && colStart < last.colEnd)) {
+        _sorted = false;
+      }
+    }
+    _runs.push_back({row, colStart, colEnd});
+  }
+
+  /// \brief Sort the runs by row and col and fuse contiguous runs
+  void sortRuns() {
+    if (_sorted) {
+      return;
+    }
+    std::sort(_runs.begin(), _runs.end(), [](const RowRun &a, const RowRun &b) {
+      return a.row < b.row || (a.row == b.row && a.colStart < b.colStart);
+    });
+    size_t last = 0;
+    for (size_t i = 1; i < _runs.size(); ++i) {
+      if (_runs[i].row == _runs[last].row && _runs[i].colStart <= _runs[last].colEnd) {
+        _runs[last].colEnd = std::max(_runs[last].colEnd, _runs[i].colEnd);
+      } else {
+        _runs[++last] = _runs[i];
+      }
+    }
+    if (!_runs.empty()) {
+      _runs.resize(last + 1);
+    }
+    _sorted = true;
+  }
 
   Blob *
       _parent = nullptr;  ///< Blob parent, used by the Union find algorithm
@@ -391,11 +423,14 @@ class Blob {
       _colMax{};          ///< Maximum bounding box col (in the global coordinates of the image)
 
   uint64_t
-      _count = 0;           ///< Number of pixel to fastened the blob merge
+      _count = 0,           ///< Number of pixel to fastened the blob merge
+      _intensitySum = 0;    ///< Sum of the pixel intensities, for the hole mean intensity after merge
+
+  std::vector<RowRun>
+      _runs
+      {};         ///< Sparse matrix of runs composing the blob
 
-  std::unordered_map<int32_t, std::unordered_set<int32_t>>
-      _rowCols
-      {};         ///< Sparse matrix of unique coordinates composing the blob
+  bool _sorted = true;  ///< True if the runs are sorted and do not overlap
 
   bool _toMerge = false;
 
@@ -0,0 +1,81 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_BLOBBATCH_H
+#define NEWEGT_BLOBBATCH_H
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <htgs/api/IData.hpp>
+#include <egt/FeatureCollection/Data/Blob.h>
+
+namespace egt {
+
+    /**
+     * Erosion of a feature too large for a single task, done by bands of rows.
+     * The eroded bitmask is complete once all the bands are eroded.
+     */
+    struct BandedErosion {
+
+        /// \brief BandedErosion constructor
+        /// \param blob Blob whose feature is eroded
+        /// \param nbWords Number of words of the feature bitmask
+        BandedErosion(Blob *blob, uint64_t nbWords) : blob(blob), bitMask(new uint32_t[nbWords]()) {}
+
+        Blob *
+                blob;                   ///< Blob whose feature is eroded
+        uint32_t *
+                bitMask;                ///< Eroded bitmask, given to the blob once complete
+        std::atomic<uint64_t>
+                count{0};               ///< Number of foreground pixels in the eroded bands
+    };
+
+    /**
+     * Group of blobs processed by the same task, or a band of rows of a large feature. The blobs are not owned by
+     * the batch.
+     */
+    class BlobBatch : public htgs::IData {
+
+    public:
+
+        /// \brief BlobBatch constructor
+        /// \param blobs Blobs of the batch
+        explicit BlobBatch(std::vector<Blob *> blobs) : _blobs(std::move(blobs)) {}
+
+        /// \brief BlobBatch constructor for a band of rows of a large feature
+        /// \param erosion Erosion of the feature
+        /// \param rowBegin First row of the band
+        /// \param rowEnd Row after the last row of the band
+        BlobBatch(std::shared_ptr<BandedErosion> erosion, uint32_t rowBegin, uint32_t rowEnd) :
+                _erosion(std::move(erosion)), _rowBegin(rowBegin), _rowEnd(rowEnd) {}
+
+        /// \return Blobs of the batch
+        const std::vector<Blob *> &getBlobs() const { return _blobs; }
+
+        /// \return Erosion of the large feature whose band is processed, nullptr for a group of blobs
+        const std::shared_ptr<BandedErosion> &getErosion() const { return _erosion; }
+
+        /// \return First row of the band
+        uint32_t getRowBegin() const { return _rowBegin; }
+
+        /// \return Row after the last row of the band
+        uint32_t getRowEnd() const { return _rowEnd; }
+
+    private:
+
+        std::vector<Blob *>
+                _blobs{};   ///< Blobs of the batch
+
+        std::shared_ptr<BandedErosion>
+                _erosion{}; ///< Erosion of a large feature, nullptr for a group of blobs
+
+        uint32_t
+                _rowBegin{},    ///< First row of the band
+                _rowEnd{};      ///< Row after the last row of the band
+    };
+}
+
+#endif //NEWEGT_BLOBBATCH_H
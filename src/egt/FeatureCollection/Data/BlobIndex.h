@@ -0,0 +1,149 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_BLOBINDEX_H
+#define NEWEGT_BLOBINDEX_H
+
+#include <cstdint>
+#include <list>
+#include <vector>
+#include "Blob.h"
+
+namespace egt {
+
+    /**
+     * Spatial index retrieving the blob containing a global pixel coordinate.
+     *
+     * Merge coordinates recorded by the view analyzers always point to the first row or the first column of
+     * a neighboring tile. For each tile, we keep an array giving the blob owning each pixel of its first row
+     * and of its first column, so those coordinates are resolved in constant time.
+     * Other coordinates (i.e neighbors of filled up holes) are resolved by looking only at the blobs whose
+     * bounding box intersects the tile containing the coordinate.
+     *
+     * The index can also cover only a region of the image aligned on the tiles, coordinates are always global.
+     *
+     * Blobs must have been compacted into features before being indexed.
+     */
+    class BlobIndex {
+
+    public:
+
+        /// \brief Build the index.
+        /// \param imageHeight Image height
+        /// \param imageWidth Image width
+        /// \param tileHeight Tile height
+        /// \param tileWidth Tile width
+        /// \param blobs Blobs to index
+        BlobIndex(uint32_t imageHeight, uint32_t imageWidth, uint32_t tileHeight, uint32_t tileWidth,
+                  const std::list<Blob *> &blobs) :
+                BlobIndex(0, 0, imageHeight, imageWidth, tileHeight, tileWidth, blobs) {}
+
+        /// \brief Build the index of a region of the image.
+        /// \param rowOffset Region first row, multiple of the tile height
+        /// \param colOffset Region first col, multiple of the tile width
+        /// \param height Region height
+        /// \param width Region width
+        /// \param tileHeight Tile height
+        /// \param tileWidth Tile width
+        /// \param blobs Blobs to index, contained in the region
+        template<class Container>
+        BlobIndex(uint32_t rowOffset, uint32_t colOffset, uint32_t height, uint32_t width,
+                  uint32_t tileHeight, uint32_t tileWidth, const Container &blobs) :
+                _rowOffset(rowOffset), _colOffset(colOffset), _imageHeight(height), _imageWidth(width),
+                _tileHeight(tileHeight), _tileWidth(tileWidth) {
+
+            _nbTilesHeight = (height + tileHeight - 1) / tileHeight;
+            _nbTilesWidth = (width + tileWidth - 1) / tileWidth;
+
+            _firstRows.resize((uint64_t) _nbTilesHeight * _imageWidth, nullptr);
+            _firstCols.resize((uint64_t) _nbTilesWidth * _imageHeight, nullptr);
+            _tiles.resize((uint64_t) _nbTilesHeight * _nbTilesWidth);
+
+            for (auto blob : blobs) {
+                addBlob(blob);
+            }
+        }
+
+        /// \brief Find the blob containing a pixel.
+        /// \param row Global row
+        /// \param col Global col
+        /// \return The blob containing the pixel, nullptr if no blob contains it.
+        Blob *find(int32_t row, int32_t col) const {
+            row -= (int32_t) _rowOffset;
+            col -= (int32_t) _colOffset;
+            if (row < 0 || col < 0 || (uint32_t) row >= _imageHeight || (uint32_t) col >= _imageWidth) {
+                return nullptr;
+            }
+
+            // Every pixel on a tile first row or first col is indexed
+            if (row % _tileHeight == 0) {
+                return _firstRows[(uint64_t) (row / _tileHeight) * _imageWidth + col];
+            }
+            if (col % _tileWidth == 0) {
+                return _firstCols[(uint64_t) (col / _tileWidth) * _imageHeight + row];
+            }
+
+            for (auto blob : _tiles[(uint64_t) (row / _tileHeight) * _nbTilesWidth + col / _tileWidth]) {
+                if (blob->isPixelinFeature(row + (int32_t) _rowOffset, col + (int32_t) _colOffset)) {
+                    return blob;
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+
+        void addBlob(Blob *blob) {
+            auto rowMin = (uint32_t) blob->getRowMin() - _rowOffset,
+                    rowMax = (uint32_t) blob->getRowMax() - _rowOffset,
+                    colMin = (uint32_t) blob->getColMin() - _colOffset,
+                    colMax = (uint32_t) blob->getColMax() - _colOffset;
+
+            // first rows of tiles crossed by the blob
+            for (auto row = ((rowMin + _tileHeight - 1) / _tileHeight) * _tileHeight; row < rowMax; row += _tileHeight) {
+                auto firstRow = &_firstRows[(uint64_t) (row / _tileHeight) * _imageWidth];
+                for (auto col = colMin; col < colMax; ++col) {
+                    if (blob->isPixelinFeature(row + _rowOffset, col + _colOffset)) {
+                        firstRow[col] = blob;
+                    }
+                }
+            }
+
+            // first cols of tiles crossed by the blob
+            for (auto col = ((colMin + _tileWidth - 1) / _tileWidth) * _tileWidth; col < colMax; col += _tileWidth) {
+                auto firstCol = &_firstCols[(uint64_t) (col / _tileWidth) * _imageHeight];
+                for (auto row = rowMin; row < rowMax; ++row) {
+                    if (blob->isPixelinFeature(row + _rowOffset, col + _colOffset)) {
+                        firstCol[row] = blob;
+                    }
+                }
+            }
+
+            for (auto tileRow = rowMin / _tileHeight; tileRow <= (rowMax - 1) / _tileHeight; ++tileRow) {
+                for (auto tileCol = colMin / _tileWidth; tileCol <= (colMax - 1) / _tileWidth; ++tileCol) {
+                    _tiles[(uint64_t) tileRow * _nbTilesWidth + tileCol].push_back(blob);
+                }
+            }
+        }
+
+        uint32_t
+                _rowOffset{},       ///< Indexed region first row
+                _colOffset{},       ///< Indexed region first col
+                _imageHeight{},     ///< Indexed region height
+                _imageWidth{},      ///< Indexed region width
+                _tileHeight{},
+                _tileWidth{},
+                _nbTilesHeight{},
+                _nbTilesWidth{};
+
+        std::vector<Blob *>
+                _firstRows{},   ///< Blob owning each pixel of the tiles first row, for each row of tiles
+                _firstCols{};   ///< Blob owning each pixel of the tiles first col, for each col of tiles
+
+        std::vector<std::vector<Blob *>>
+                _tiles{};       ///< Blobs whose bounding box intersects each tile
+    };
+}
+
+#endif //NEWEGT_BLOBINDEX_H
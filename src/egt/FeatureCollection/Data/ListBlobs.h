@@ -35,9 +35,11 @@
 #define FASTIMAGE_LISTBLOBS_H
 
 #include "Blob.h"
-#include <egt/loaders/FeatureBitmaskLoader.h>
 #include <egt/FeatureCollection/algorithms/bitmaskAlgorithms.h>
 #include <egt/api/EGTOptions.h>
+#include <egt/FeatureCollection/Tasks/FeatureEroder.h>
+#include <htgs/api/TaskGraphConf.hpp>
+#include <htgs/api/TaskGraphRuntime.hpp>
 
 namespace egt {
 /// \namespace fc FeatureCollection namespace
@@ -62,133 +64,53 @@ struct ListBlobs : public IData {
 
         VLOG(1) << "erode feature collection";
 
-        //TODO CHECK HARDCODED VALUES. Should we parameterize?
-        uint8_t foregroundValue = 255;
-        uint64_t largeFeatureCutoff = 2048 * 2048;
-        uint32_t tilesize = 1024;
-
-        for(auto &blob : _blobs) {
-            auto feature = blob->getFeature();
-
-            auto width = feature->getBoundingBox().getWidth();
-            auto height = feature->getBoundingBox().getHeight();
-
-            uint32_t* bitMask;
-            uint64_t maskCount = 0;
-
-            //if we have a large feature, we divide the bitmask into tile and process them separately.
-            if(width * height > largeFeatureCutoff) {
-
-                VLOG(3) << "eroding a large feature of size: " << width * height << ". Let start a fast image to process it";
-
-                //prepare bitmask for the full feature
-                bitMask = new uint32_t[(uint32_t) ceil((width * height) / 32.)]{0};
-
-                auto loader = new FeatureBitmaskLoader<int>(*feature, tilesize, foregroundValue, options->nbLoaderThreads);
-                auto fi = new fi::FastImage<int>(loader,0);
-                fi->getFastImageOptions()->setNumberOfViewParallel(options->concurrentTiles);
-                fi->configureAndRun();
-                fi->requestAllTiles(true);
-                while(fi->isGraphProcessingTiles()) {
-
-                    auto pview = fi->getAvailableViewBlocking();
-                    if (pview != nullptr) {
-                        //collect data
-                        auto view = pview->get();
-                        auto data = view->getData();
-                        auto tileHeight = view->getTileHeight();
-                        auto tileWidth = view->getTileWidth();
-
-                        //perform erosion
-                        auto mat = cv::Mat(tileHeight, tileWidth, CV_8U,  data);
-                        auto kernel = cv::getStructuringElement(cv::MORPH_ERODE,cv::Size(3,3), cv::Point(1,1));
-                        cv::Mat eroded;
-                        cv::erode(mat,eroded,kernel);
-                        mat.release();
-                        //transform back the matrix to an array
-                        std::vector<uchar> array;
-                        if (eroded.isContinuous()) {
-                            array.assign((uchar*)eroded.datastart, (uchar*)eroded.dataend);
-                        } else {
-                            for (int i = 0; i < eroded.rows; ++i) {
-                                array.insert(array.end(), eroded.ptr<uchar>(i), eroded.ptr<uchar>(i)+eroded.cols);
-                            }
-                        }
-                        eroded.release();
-
-                        //copy back to the bitmask
-                        uint32_t
-                                rowMin = (uint32_t) view->getGlobalYOffset(),
-                                colMin = (uint32_t) view->getGlobalXOffset(),
-                                rowMax = (uint32_t) view->getGlobalYOffset() + tileHeight,
-                                colMax = (uint32_t) view->getGlobalXOffset() + tileWidth,
-                                ulRowL = 0,
-                                ulColL = 0,
-                                wordPosition = 0,
-                                bitPositionInDecimal = 0,
-                                absolutePosition = 0;
-
-                        auto erodedData = array.data();
-                        auto foregroundPixelCount = BitmaskAlgorithms::copyArrayToBitmask<uint8_t>(erodedData, bitMask, foregroundValue, rowMin, colMin, rowMax, colMax, width);
-                        maskCount += foregroundPixelCount;
-
-                        pview->releaseMemory();
-                    }
-                }
-                fi->waitForGraphComplete();
-                delete fi;
-
-                if (maskCount < segmentationOptions->MIN_OBJECT_SIZE) {
-                    VLOG(3) << "delete eroded feature. Reason : feature size < "
-                            << segmentationOptions->MIN_OBJECT_SIZE;
-                    delete[] bitMask;
-                    continue;
+        //number of bitmask pixels sent at once to an eroder thread, a larger feature is split in bands of rows
+        uint64_t batchArea = 2048 * 2048;
+        //maximum number of features sent at once to an eroder thread
+        size_t batchSize = 256;
+
+        //features are eroded in parallel by a pool of eroder threads
+        auto erodeGraph = new htgs::TaskGraphConf<BlobBatch, htgs::VoidData>();
+        auto eroder = new FeatureEroder(std::max(options->nbErodeThreads, (uint32_t) 1), segmentationOptions);
+        erodeGraph->setGraphConsumerTask(eroder);
+        auto erodeRuntime = new htgs::TaskGraphRuntime(erodeGraph);
+        erodeRuntime->executeRuntime();
+
+        std::vector<Blob *> batch;
+        std::vector<std::shared_ptr<BandedErosion>> erosions;
+        uint64_t area = 0;
+        for (auto blob : _blobs) {
+            auto bb = blob->getFeature()->getBoundingBox();
+            auto blobArea = (uint64_t) bb.getWidth() * bb.getHeight();
+            if (blobArea > batchArea) {
+                //bands start on multiples of 32 rows, so they start on a word and share no word of the bitmask
+                uint32_t bandHeight = (uint32_t) ((batchArea / bb.getWidth() + 31) / 32 * 32);
+                auto erosion = std::make_shared<BandedErosion>(blob, (blobArea + 31) / 32);
+                for (uint32_t rowBegin = 0; rowBegin < bb.getHeight(); rowBegin += bandHeight) {
+                    erodeGraph->produceData(std::make_shared<BlobBatch>(
+                            erosion, rowBegin, std::min(rowBegin + bandHeight, bb.getHeight())));
                 }
+                erosions.push_back(erosion);
+                continue;
             }
-            else {
-                //transform each bitMask into a array of uint8 so we can use opencv
-                auto data = BitmaskAlgorithms::bitMaskToArray(feature->getBitMask(), width, height, foregroundValue);
-
-                auto mat = cv::Mat(height, width, CV_8U, data);
-                auto kernel = cv::getStructuringElement(cv::MORPH_ERODE, cv::Size(3, 3), cv::Point(1, 1));
-                cv::Mat eroded;
-                cv::erode(mat, eroded, kernel);
-                mat.release();
-                delete[] data;
-
-                maskCount = (uint64_t) countNonZero(eroded);
-
-                if (maskCount < segmentationOptions->MIN_OBJECT_SIZE) {
-                    eroded.release();
-                    VLOG(3) << "delete eroded feature. Reason : feature size < "
-                            << segmentationOptions->MIN_OBJECT_SIZE;
-                    continue;
-                }
-
-                //transform back the matrix to an array
-                std::vector<uchar> array;
-                if (eroded.isContinuous()) {
-                    array.assign((uchar *) eroded.datastart, (uchar *) eroded.dataend);
-                } else {
-                    for (int i = 0; i < eroded.rows; ++i) {
-                        array.insert(array.end(), eroded.ptr<uchar>(i), eroded.ptr<uchar>(i) + eroded.cols);
-                    }
-                }
-                eroded.release();
-
-                //transform back the array to a bitmask
-                bitMask = BitmaskAlgorithms::arrayToBitMask(array.data(), width, height, foregroundValue);
+            if (!batch.empty() && (area + blobArea > batchArea || batch.size() == batchSize)) {
+                erodeGraph->produceData(std::make_shared<BlobBatch>(std::move(batch)));
+                batch = std::vector<Blob *>();
+                area = 0;
             }
+            batch.push_back(blob);
+            area += blobArea;
+        }
+        if (!batch.empty()) {
+            erodeGraph->produceData(std::make_shared<BlobBatch>(std::move(batch)));
+        }
+        erodeGraph->finishedProducingData();
+
+        erodeRuntime->waitForRuntime();
+        delete erodeRuntime;
 
-            blob->setFeature(new Feature(feature->getId(), feature->getBoundingBox(), bitMask));
-            blob->setCount(maskCount);
-            auto bb = feature->getBoundingBox();
-            blob->setColMin(bb.getUpperLeftCol());
-            blob->setRowMin(bb.getUpperLeftRow());
-            blob->setColMax(bb.getBottomRightCol());
-            blob->setRowMax(bb.getBottomRightRow());
-            delete[] feature->getBitMask();
-            delete feature;
+        for (const auto &erosion : erosions) {
+            FeatureEroder::completeErosion(erosion->blob, erosion->bitMask, erosion->count, segmentationOptions);
         }
     }
 
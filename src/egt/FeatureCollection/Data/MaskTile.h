@@ -0,0 +1,95 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_MASKTILE_H
+#define NEWEGT_MASKTILE_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <htgs/api/IData.hpp>
+#include <htgs/api/MemoryData.hpp>
+
+namespace egt {
+
+    /// \brief Layout of a resolution level of a mask, level n being downsampled by 2^n.
+    struct MaskLevel {
+        uint32_t
+                width{},        ///< Level width
+                height{},       ///< Level height
+                nbTileRows{},   ///< Number of tile rows
+                nbTileCols{};   ///< Number of tile cols
+
+        uint64_t
+                firstIndex{};   ///< Index of the first tile of the level
+    };
+
+    /**
+     * Tile of a mask being written.
+     *
+     * The tile pixels come from the "maskTile" memory manager once the tile is scheduled, and are released once the
+     * tile is encoded.
+     */
+    template<class T>
+    class MaskTile : public htgs::IData {
+
+    public:
+
+        /// \brief MaskTile constructor
+        /// \param index Index of the tile, tiles being ordered by level then in row major order
+        /// \param level Resolution level of the tile
+        /// \param row Tile row
+        /// \param col Tile col
+        MaskTile(uint64_t index, uint32_t level, uint32_t row, uint32_t col) :
+                _index(index), _level(level), _row(row), _col(col) {}
+
+        /// \return Index of the tile, tiles being ordered by level then in row major order
+        uint64_t getIndex() const { return _index; }
+
+        /// \return Resolution level of the tile
+        uint32_t getLevel() const { return _level; }
+
+        /// \return Tile row
+        uint32_t getRow() const { return _row; }
+
+        /// \return Tile col
+        uint32_t getCol() const { return _col; }
+
+        /// \return Tile pixels, stored row by row with a stride of the tile size
+        T *getPixels() const { return _pixels->get(); }
+
+        /// \brief Attach the tile pixels.
+        void setPixels(const htgs::m_data_t<T> &pixels) { _pixels = pixels; }
+
+        /// \brief Give the tile pixels back to their memory manager.
+        void releasePixels() {
+            _pixels->releaseMemory();
+            _pixels = nullptr;
+        }
+
+        /// \return Encoded tile, as it is stored in the file
+        const std::vector<uint8_t> &getEncoded() const { return _encoded; }
+
+        /// \brief Set the encoded tile.
+        void setEncoded(std::vector<uint8_t> encoded) { _encoded = std::move(encoded); }
+
+    private:
+
+        uint64_t
+                _index{};   ///< Index of the tile
+
+        uint32_t
+                _level{},   ///< Resolution level of the tile
+                _row{},     ///< Tile row
+                _col{};     ///< Tile col
+
+        htgs::m_data_t<T>
+                _pixels = nullptr;  ///< Tile pixels
+
+        std::vector<uint8_t>
+                _encoded{};         ///< Encoded tile
+    };
+}
+
+#endif //NEWEGT_MASKTILE_H
@@ -0,0 +1,58 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_MERGEJOB_H
+#define NEWEGT_MERGEJOB_H
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <htgs/api/IData.hpp>
+#include <egt/FeatureCollection/Data/ViewAnalyse.h>
+
+namespace egt {
+
+    /**
+     * Analyses of up to 2x2 neighboring regions of a merge level, to be merged into their parent region.
+     *
+     * A region of level n covers 2^n x 2^n tiles. Its row and col are given in regions of its level.
+     */
+    class MergeJob : public htgs::IData {
+
+    public:
+
+        /// \brief MergeJob constructor
+        /// \param level Level of the parent region
+        /// \param row Row of the parent region
+        /// \param col Col of the parent region
+        /// \param children Analyses of the regions covered by the parent region
+        MergeJob(uint32_t level, uint32_t row, uint32_t col, std::vector<std::shared_ptr<ViewAnalyse>> children) :
+                _level(level), _row(row), _col(col), _children(std::move(children)) {}
+
+        /// \return Level of the parent region
+        uint32_t getLevel() const { return _level; }
+
+        /// \return Row of the parent region
+        uint32_t getRow() const { return _row; }
+
+        /// \return Col of the parent region
+        uint32_t getCol() const { return _col; }
+
+        /// \return Analyses of the regions to merge
+        const std::vector<std::shared_ptr<ViewAnalyse>> &getChildren() const { return _children; }
+
+    private:
+
+        uint32_t
+                _level{},   ///< Level of the parent region
+                _row{},     ///< Row of the parent region
+                _col{};     ///< Col of the parent region
+
+        std::vector<std::shared_ptr<ViewAnalyse>>
+                _children{};    ///< Analyses of the regions to merge
+    };
+}
+
+#endif //NEWEGT_MERGEJOB_H
@@ -0,0 +1,155 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_TILEBITMAP_H
+#define NEWEGT_TILEBITMAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace egt {
+
+    /**
+     * One bit per pixel map of a tile, with a halo around it (one pixel by default).
+     *
+     * Rows and cols range from -halo to height / width + halo excluded, so the neighbors of every tile pixel can be
+     * looked up. Each row is stored on whole 64 bits words, col -halo being the lowest bit of the first word.
+     * The buffer is kept between tiles, so a task instance can reuse it for every tile it processes.
+     */
+    class TileBitmap {
+
+    public:
+
+        /// \brief Resize the bitmap for a tile and clear all its bits.
+        /// \param height Tile height
+        /// \param width Tile width
+        /// \param halo Halo width
+        void reset(int32_t height, int32_t width, int32_t halo = 1) {
+            _height = height;
+            _width = width;
+            _halo = halo;
+            _stride = ((uint32_t) (width + 2 * halo) + 63) / 64;
+            _words.assign((size_t) (height + 2 * halo) * _stride, 0);
+        }
+
+        /// \brief Set the bits of the pixels strictly above a threshold, halo included.
+        /// \param data View pixels
+        /// \param viewWidth View width
+        /// \param radius View radius, at least the halo width
+        /// \param threshold Pixels above this value are set
+        template<class T>
+        void threshold(const T *data, uint32_t viewWidth, uint32_t radius, T threshold) {
+            const auto nbCols = (uint32_t) (_width + 2 * _halo);
+            uint8_t above[64];
+
+            for (int32_t row = -_halo; row < _height + _halo; ++row) {
+                const T *src = data + (size_t) (row + radius) * viewWidth + radius - _halo;
+                uint64_t *words = &_words[(size_t) (row + _halo) * _stride];
+
+                for (uint32_t word = 0; word < _stride; ++word) {
+                    auto count = std::min(64u, nbCols - word * 64);
+                    //branch free compare the compiler can vectorize, the flags are then packed 8 at a time
+                    for (uint32_t k = 0; k < count; ++k) {
+                        above[k] = src[k] > threshold;
+                    }
+                    std::memset(above + count, 0, 64 - count);
+                    uint64_t bits = 0;
+                    for (uint32_t byte = 0; byte < 8; ++byte) {
+                        uint64_t flags;
+                        std::memcpy(&flags, above + 8 * byte, sizeof(flags));
+                        bits |= ((flags * 0x0102040810204080ull) >> 56u) << (8 * byte);
+                    }
+                    words[word] = bits;
+                    src += 64;
+                }
+            }
+        }
+
+        /// \brief Erode a bitmap of the same tile with a 3x3 square kernel into this bitmap.
+        /// \details This bitmap is resized to cover the source bitmap minus one pixel of halo, the source halo
+        /// providing the neighbors of every pixel. Each row is computed 64 pixels at a time.
+        /// \param source Bitmap to erode, with a halo of at least 2 pixels
+        void erode(const TileBitmap &source) {
+            reset(source._height, source._width, source._halo - 1);
+            const auto nbCols = (uint32_t) (_width + 2 * _halo);
+
+            for (int32_t row = 0; row < _height + 2 * _halo; ++row) {
+                //this bitmap row r is the source row r + 1, its col c the source col c + 1
+                const uint64_t *above = &source._words[(size_t) row * source._stride],
+                        *center = above + source._stride,
+                        *below = center + source._stride;
+                uint64_t *words = &_words[(size_t) row * _stride];
+
+                for (uint32_t word = 0; word < _stride; ++word) {
+                    auto bits = above[word] & center[word] & below[word];
+                    uint64_t next = 0;
+                    if (word + 1 < source._stride) {
+                        next = above[word + 1] & center[word + 1] & below[word + 1];
+                    }
+                    //bit b of the result gathers the source bits b, b + 1 and b + 2
+                    auto left = bits, middle = (bits >> 1u) | (next << 63u), right = (bits >> 2u) | (next << 62u);
+                    words[word] = left & middle & right;
+                }
+                //keep the bits past the last col cleared
+                if (nbCols % 64 != 0) {
+                    words[_stride - 1] &= ~(uint64_t) 0 >> (64 - nbCols % 64);
+                }
+            }
+        }
+
+        /// \brief Set or clear all the bits outside a rectangle, halo included.
+        /// \param rowBegin First row of the rectangle
+        /// \param rowEnd Row after the last row of the rectangle
+        /// \param colBegin First col of the rectangle
+        /// \param colEnd Col after the last col of the rectangle
+        /// \param value Value of the bits outside the rectangle
+        void fillOutside(int32_t rowBegin, int32_t rowEnd, int32_t colBegin, int32_t colEnd, bool value) {
+            for (int32_t row = -_halo; row < _height + _halo; ++row) {
+                bool rowOutside = row < rowBegin || row >= rowEnd;
+                for (int32_t col = -_halo; col < _width + _halo; ++col) {
+                    if (rowOutside || col < colBegin || col >= colEnd) {
+                        value ? set(row, col) : clear(row, col);
+                    } else {
+                        col = std::max(col, colEnd - 1);
+                    }
+                }
+            }
+        }
+
+        /// \return True if the pixel bit is set.
+        inline bool test(int32_t row, int32_t col) const {
+            auto bit = (uint32_t) (col + _halo);
+            return (_words[(size_t) (row + _halo) * _stride + (bit >> 6u)] >> (bit & 63u)) & 1u;
+        }
+
+        /// \brief Set the pixel bit.
+        inline void set(int32_t row, int32_t col) {
+            auto bit = (uint32_t) (col + _halo);
+            _words[(size_t) (row + _halo) * _stride + (bit >> 6u)] |= (uint64_t) 1 << (bit & 63u);
+        }
+
+        /// \brief Clear the pixel bit.
+        inline void clear(int32_t row, int32_t col) {
+            auto bit = (uint32_t) (col + _halo);
+            _words[(size_t) (row + _halo) * _stride + (bit >> 6u)] &= ~((uint64_t) 1 << (bit & 63u));
+        }
+
+    private:
+
+        int32_t
+                _height{},      ///< Tile height
+                _width{},       ///< Tile width
+                _halo = 1;      ///< Halo width
+
+        uint32_t
+                _stride{};      ///< Number of words per row
+
+        std::vector<uint64_t>
+                _words{};       ///< Bits, row by row
+    };
+}
+
+#endif //NEWEGT_TILEBITMAP_H
@@ -57,6 +57,24 @@ namespace egt {
 class ViewAnalyse : public htgs::IData {
  public:
 
+  /// \brief ViewAnalyse constructor
+  /// \param row Row of the analysed tile, or of the merged region at its level
+  /// \param col Col of the analysed tile, or of the merged region at its level
+  /// \param level Merge level. A region of level n covers 2^n x 2^n tiles, a tile is level 0.
+  explicit ViewAnalyse(uint32_t row = 0, uint32_t col = 0, uint32_t level = 0) : _row(row), _col(col), _level(level) {}
+
+  /// \brief Get the row of the analysed tile
+  /// \return Tile row
+  uint32_t getRow() const { return _row; }
+
+  /// \brief Get the col of the analysed tile
+  /// \return Tile col
+  uint32_t getCol() const { return _col; }
+
+  /// \brief Get the merge level
+  /// \return Merge level, 0 for a tile
+  uint32_t getLevel() const { return _level; }
+
     void tidy(){
             //TODO we could remove from merge list if we have tiny amount of pixel
             VLOG(1) << "tidying up contiguous pixels";
@@ -79,6 +97,14 @@ class ViewAnalyse : public htgs::IData {
 
   const std::list<Blob *> &getHoles() const { return _holes; }
 
+  /// \brief Getter to the blobs of a merged region that cannot be merged anymore
+  /// \return The completed blobs list
+  std::list<Blob *> &getCompletedBlobs() { return _completedBlobs; }
+
+  /// \brief Getter to the holes of a merged region that cannot be merged anymore
+  /// \return The completed holes list
+  std::list<Blob *> &getCompletedHoles() { return _completedHoles; }
+
   /// \brief Add an entry to the to merge structure
   /// \param b Blob to add
   /// \param c Coordinate links to this  blob
@@ -96,6 +122,12 @@ class ViewAnalyse : public htgs::IData {
 
   void insertHole(Blob *b) { _holes.push_back(b); }
 
+  /// \brief Insert a blob that cannot be merged anymore
+  /// \param b blob to add
+  void insertCompletedBlob(Blob *b) { _completedBlobs.push_back(b); }
+
+  void insertCompletedHole(Blob *b) { _completedHoles.push_back(b); }
+
   virtual ~ViewAnalyse() {
         _toMerge.clear();
         _blobs.clear();
@@ -117,6 +149,15 @@ private:
 
   std::list<Blob *>
       _holes{};   ///< List of holes created
+
+  std::list<Blob *>
+      _completedBlobs{},  ///< Blobs of a merged region not touching its borders
+      _completedHoles{};  ///< Holes of a merged region not touching its borders
+
+  uint32_t
+      _row = 0,   ///< Row of the analysed tile
+      _col = 0,   ///< Col of the analysed tile
+      _level = 0; ///< Merge level
 };
 }
 #endif //EGT_REGIONLABELING_VIEWANALYSE_H
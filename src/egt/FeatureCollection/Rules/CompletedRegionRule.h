@@ -0,0 +1,57 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_COMPLETEDREGIONRULE_H
+#define NEWEGT_COMPLETEDREGIONRULE_H
+
+#include <htgs/api/IRule.hpp>
+#include <egt/FeatureCollection/Data/ViewAnalyse.h>
+#include <egt/FeatureCollection/algorithms/regionMerge.h>
+
+namespace egt {
+
+    /**
+     * Forward the analyse of every region, tiles included, so its completed blobs are filtered as soon as the
+     * region is built instead of being carried up the merge tree.
+     *
+     * The merge bookkeeper applies all its rules to an analyse before it receives the next one, so an analyse is
+     * always forwarded before its parent region is built, and the root region covering the whole image comes last.
+     */
+    class CompletedRegionRule : public htgs::IRule<ViewAnalyse, ViewAnalyse> {
+
+    public:
+
+        /// \brief CompletedRegionRule constructor
+        /// \param imageHeight Image height
+        /// \param imageWidth Image width
+        /// \param tileHeight Tile height
+        /// \param tileWidth Tile width
+        CompletedRegionRule(uint32_t imageHeight, uint32_t imageWidth, uint32_t tileHeight, uint32_t tileWidth) :
+                _rootLevel(RegionMerge(imageHeight, imageWidth, tileHeight, tileWidth).getRootLevel()) {}
+
+        void applyRule(std::shared_ptr<ViewAnalyse> data, size_t pipelineId) override {
+            if (data->getLevel() == _rootLevel) {
+                _rootSent = true;
+            }
+            this->addResult(data);
+        }
+
+        /// \brief The rule is done once the analyse of the root region has been sent.
+        bool canTerminateRule(size_t pipelineId) override {
+            return _rootSent;
+        }
+
+        std::string getName() override { return "Completed Region Rule"; }
+
+    private:
+
+        uint32_t
+                _rootLevel{};       ///< Level of the region covering the whole image
+
+        bool
+                _rootSent = false;  ///< True once the root region analyse has been sent
+    };
+}
+
+#endif //NEWEGT_COMPLETEDREGIONRULE_H
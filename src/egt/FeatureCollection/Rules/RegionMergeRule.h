@@ -0,0 +1,75 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_REGIONMERGERULE_H
+#define NEWEGT_REGIONMERGERULE_H
+
+#include <unordered_map>
+#include <htgs/api/IRule.hpp>
+#include <egt/FeatureCollection/Data/MergeJob.h>
+#include <egt/FeatureCollection/Data/ViewAnalyse.h>
+#include <egt/FeatureCollection/algorithms/regionMerge.h>
+
+namespace egt {
+
+    /**
+     * Gather the analyses of the regions covered by the same parent region, and emit a merge job once they
+     * have all been received.
+     *
+     * Analyses of the root level are only forwarded by the CompletedRegionRule.
+     */
+    class RegionMergeRule : public htgs::IRule<ViewAnalyse, MergeJob> {
+
+    public:
+
+        /// \brief RegionMergeRule constructor
+        /// \param imageHeight Image height
+        /// \param imageWidth Image width
+        /// \param tileHeight Tile height
+        /// \param tileWidth Tile width
+        RegionMergeRule(uint32_t imageHeight, uint32_t imageWidth, uint32_t tileHeight, uint32_t tileWidth) :
+                _regionMerge(imageHeight, imageWidth, tileHeight, tileWidth),
+                _rootLevel(_regionMerge.getRootLevel()) {}
+
+        void applyRule(std::shared_ptr<ViewAnalyse> data, size_t pipelineId) override {
+            if (data->getLevel() >= _rootLevel) {
+                return;
+            }
+
+            auto level = data->getLevel() + 1, row = data->getRow() / 2, col = data->getCol() / 2;
+            auto key = ((uint64_t) level << 58u) | ((uint64_t) row << 29u) | col;
+            auto &children = _children[key];
+            children.push_back(data);
+
+            if (children.size() == _regionMerge.getNbChildren(level, row, col)) {
+                this->addResult(std::make_shared<MergeJob>(level, row, col, std::move(children)));
+                _children.erase(key);
+                _rootJobSent = (level == _rootLevel);
+            }
+        }
+
+        /// \brief The rule is done once the job building the root region has been sent.
+        bool canTerminateRule(size_t pipelineId) override {
+            return _rootLevel == 0 || _rootJobSent;
+        }
+
+        std::string getName() override { return "Region Merge Rule"; }
+
+    private:
+
+        RegionMerge
+                _regionMerge;           ///< Regions layout
+
+        uint32_t
+                _rootLevel{};           ///< Level of the region covering the whole image
+
+        bool
+                _rootJobSent = false;   ///< True once the root region merge job has been sent
+
+        std::unordered_map<uint64_t, std::vector<std::shared_ptr<ViewAnalyse>>>
+                _children{};            ///< Analyses received for each parent region, by level, row and col
+    };
+}
+
+#endif //NEWEGT_REGIONMERGERULE_H
@@ -39,9 +39,13 @@
 #include <htgs/api/ITask.hpp>
 #include <cstdint>
 #include <utility>
+#include <chrono>
+#include <unordered_set>
 #include <FastImage/FeatureCollection/tools/UnionFind.h>
 #include <egt/FeatureCollection/Data/ListBlobs.h>
-#include <egt/utils/FeatureExtraction.h>
+#include <egt/FeatureCollection/Data/BlobIndex.h>
+#include <egt/FeatureCollection/algorithms/regionMerge.h>
+#include <egt/utils/Utils.h>
 #include <egt/api/DerivedSegmentationParams.h>
 
 namespace egt {
@@ -50,11 +54,17 @@ namespace egt {
 /**
   * @class BlobMerger BlobMerger.h <egt/FeatureCollection/Tasks/BlobMerger.h>
   *
-  * @brief Merges multiple egt::ViewAnalyse to build the Feature Collection.
+  * @brief Filters the blobs of the whole image to build the Feature Collection.
   *
-  *  Merge the different analyse with a disjoint-set data structure to represent
-  *  each blobs and merge them easily:
-  *  https://en.wikipedia.org/wiki/Disjoint-set_data_structure
+  *  Tile analyses are merged by the RegionMerger tasks, up to the root region
+  *  covering the whole image. The analyse of every region, tiles included, is
+  *  received as soon as it is built, with the blobs the region completed.
+  *  Completed holes are filtered right away: big holes are background and
+  *  are released, small holes become objects. Objects are kept until the root
+  *  arrives, since a filled hole can still be merged into them. Small holes
+  *  are then merged into their surrounding object with a disjoint-set data
+  *  structure: https://en.wikipedia.org/wiki/Disjoint-set_data_structure
+  *  and small objects are removed.
 
   **/
     template<class T>
@@ -63,9 +73,12 @@ namespace egt {
         /// \brief BlobMerger constructor
         /// \param imageHeight Image Height
         /// \param imageWidth ImageWidth
-        /// \param nbTiles Number of tiles in the image5
-        BlobMerger(uint32_t imageHeight, uint32_t imageWidth, uint32_t nbTiles,  EGTOptions *options, SegmentationOptions* segmentationOptions, DerivedSegmentationParams<T> &segmentationParams)
-                : ITask(1), imageHeight(imageHeight), imageWidth(imageWidth), _nbTiles(nbTiles), options(options), segmentationOptions(segmentationOptions), segmentationParams(segmentationParams) {
+        /// \param tileHeight Tile Height
+        /// \param tileWidth Tile Width
+        BlobMerger(uint32_t imageHeight, uint32_t imageWidth, uint32_t tileHeight, uint32_t tileWidth, EGTOptions *options, SegmentationOptions* segmentationOptions, DerivedSegmentationParams<T> &segmentationParams)
+                : ITask(1), imageHeight(imageHeight), imageWidth(imageWidth), tileHeight(tileHeight), tileWidth(tileWidth),
+                  options(options), segmentationOptions(segmentationOptions), segmentationParams(segmentationParams),
+                  _rootLevel(RegionMerge(imageHeight, imageWidth, tileHeight, tileWidth).getRootLevel()) {
             _blobs = new ListBlobs();
             _holes = new ListBlobs();
         }
@@ -76,51 +89,45 @@ namespace egt {
             delete _holes;
         }
 
-        /// \brief Get the view analyse, merge them into one analyse and merge all
-        /// blob to build the feature collection
-        /// \param data View analyse
+        /// \brief Filter the blobs completed by a region. Once the root region arrives, merge the filled holes
+        /// into their surrounding object and filter the objects to build the feature collection.
+        /// \param data Region analyse
         void executeTask(std::shared_ptr<ViewAnalyse> data) override {
 
-            // for each new tile, collect blobs
-            for (auto blobListCoordToMerge : data->getToMerge()) {
-                this->_toMerge[blobListCoordToMerge.first]
-                        .merge(blobListCoordToMerge.second);
+            auto startMerge = std::chrono::high_resolution_clock::now();
+
+            _nbHoles += data->getCompletedHoles().size();
+            _nbObjects += data->getCompletedBlobs().size();
+            _holes->_blobs.splice(_holes->_blobs.end(), data->getCompletedHoles());
+            _blobs->_blobs.splice(_blobs->_blobs.end(), data->getCompletedBlobs());
+
+            //the root region has no border shared with another region, so all its blobs are complete.
+            //A single tile image is not merged at all, its blobs are directly the root region blobs.
+            bool root = (data->getLevel() == _rootLevel);
+            if (root) {
+                _nbHoles += data->getHoles().size();
+                _nbObjects += data->getBlobs().size();
+                _holes->_blobs.insert(_holes->_blobs.end(), data->getHoles().begin(), data->getHoles().end());
+                _blobs->_blobs.insert(_blobs->_blobs.end(), data->getBlobs().begin(), data->getBlobs().end());
             }
-            auto viewBlob = data->getBlobs();
-            this->_blobs->_blobs.merge(viewBlob);
 
-            //collect holes
-            for (auto blobListCoordToMerge : data->getHolesToMerge()) {
-                this->_holesToMerge[blobListCoordToMerge.first]
-                        .merge(blobListCoordToMerge.second);
-            }
-            auto holes = data->getHoles();
-            this->_holes->_blobs.merge(holes);
-
-            _count++;
-
-            //merge the blobs when all tiles have been received
-            if (_count == _nbTiles) {
+            filterHoles();
 
-                auto startMerge = std::chrono::high_resolution_clock::now();
+            if (root) {
+                VLOG(1) << "detected " << _nbHoles << " holes...";
+                VLOG(1) << "detected " << _nbObjects << " objects...";
 
-                VLOG(1) << "detected " << this->_holes->_blobs.size() << " holes..." << this->_holesToMerge.size() << " to merge.";
-                VLOG(1) << "detected " << this->_blobs->_blobs.size() << " objects..." << this->_toMerge.size() << " to merge.";
-
-                _count = 0;
-                merge(_holesToMerge,_holes, true);
-                filterHoles();
-                merge(_toMerge,_blobs, false);
+                merge(_toMerge, _blobs);
                 filterObjects();
 
-
                 VLOG(1) << "after last merge, we have : " << _blobs->_blobs.size() << " blobs left";
+            }
 
-                auto endMerge = std::chrono::high_resolution_clock::now();
-                VLOG(1) << "    Merge blobs: "
-                        << std::chrono::duration_cast<std::chrono::milliseconds>(endMerge - startMerge).count()
-                        << " mS";
+            auto endMerge = std::chrono::high_resolution_clock::now();
+            _mergeDuration += std::chrono::duration_cast<std::chrono::milliseconds>(endMerge - startMerge);
 
+            if (root) {
+                VLOG(1) << "    Merge blobs: " << _mergeDuration.count() << " mS";
                 this->addResult(_blobs);
             }
         }
@@ -133,21 +140,11 @@ namespace egt {
         /// \return itself
         BlobMerger *copy() override { return this; }
 
+        /// \brief Get the time spent filtering and merging the blobs of all the regions
+        /// \return Merge duration
+        std::chrono::milliseconds getMergeDuration() const { return _mergeDuration; }
+
     private:
-        /// \brief Retrieve a blob from a coordinate, nullptr is to blob is
-        /// corresponding
-        /// \param row Row
-        /// \param col Column
-        Blob *getBlobFromCoord(ListBlobs *blobs, const int32_t &row, const int32_t &col) const {
-            // Iterate over the blobs
-            for (auto blob : blobs->_blobs) {
-                // Test if the pixel is in the blob
-                if (blob->isPixelinFeature(row,col)) {
-                    return blob;
-                }
-            }
-            return nullptr;
-        }
 
         /**
          * Filter holes : Small holes are filled. Bigger holes are considered background.
@@ -156,11 +153,6 @@ namespace egt {
             VLOG(4) << "filter holes... ";
             uint32_t nbHolesTooSmall = 0;
             auto originalNbOfHoles = _holes->_blobs.size();
-            auto meanIntensities = new std::unordered_map<Blob *, T>();
-
-            if(! segmentationOptions->disableIntensityFilter) {
-                computeMeanIntensity<T>(_holes->_blobs, options, meanIntensities);
-            }
 
             auto i = _holes->_blobs.begin();
             while (i != _holes->_blobs.end()) {
@@ -170,7 +162,8 @@ namespace egt {
                 auto area = blob->getCount();
 
                 if(! segmentationOptions->disableIntensityFilter) {
-                    auto meanIntensity = meanIntensities->at(blob);
+                    //each tile added the intensities of its part of the hole, the image is not read again.
+                    auto meanIntensity = (T) (blob->getIntensitySum() / area);
                     keepHole = computeKeepHoleCriteria<T>(area, meanIntensity, segmentationOptions, segmentationParams);
                 }
                 else {
@@ -215,8 +208,6 @@ namespace egt {
 
             VLOG(4) << "original number of holes : " << originalNbOfHoles;
             VLOG(4) << "nb of holes filled : " << nbHolesTooSmall;
-
-            delete meanIntensities;
         }
 
         /**
@@ -248,8 +239,8 @@ namespace egt {
             VLOG(3) << "total nb of objects after filtering: " <<nbBlobs;
         }
 
-        /// \brief Merge all the blobs from all the view analyser
-        void merge(std::map<Blob *, std::list<Coordinate >> &toMerge, ListBlobs *blobs, bool isHole) {
+        /// \brief Merge the blobs linked by the remaining merge coordinates (i.e filled up holes)
+        void merge(std::map<Blob *, std::list<Coordinate >> &toMerge, ListBlobs *blobs) {
             fc::UnionFind<Blob>
                     uf{};
 
@@ -257,16 +248,20 @@ namespace egt {
                     parentSons{};
 
             // Apply the UF algorithm to every linked blob
-            for (const auto &blobCoords : toMerge) {
-                for (auto coord : blobCoords.second) {
-                    if (auto other = getBlobFromCoord(blobs, coord.first, coord.second)) {
+            {
+                BlobIndex index(imageHeight, imageWidth, tileHeight, tileWidth, blobs->_blobs);
+                for (const auto &blobCoords : toMerge) {
+                    for (auto coord : blobCoords.second) {
+                        if (auto other = index.find(coord.first, coord.second)) {
                             uf.unionElements(blobCoords.first, other);
+                        }
                     }
                 }
             }
             // Clear merge data structure. We won't use it anymore.
             toMerge.clear();
 
+            std::unordered_set<Blob *> merged{};
 
             // Building a map from the union find result.
             // Associate every blob to it parent
@@ -279,69 +274,25 @@ namespace egt {
             //One blob is considered the parent of all the others.
             for (auto &pS : parentSons) {
                 auto parent = pS.first;
-                auto sons = pS.second;
+                auto &sons = pS.second;
                 DLOG(INFO) << "nb of blobs to merge: " << sons.size();
 
-                assert(!(isHole && sons.size() == 1)); //we only collected holes that needs merge
-
-                //To merge several blobs, we calculate the resulting bounding box and fill a bitmask of the same dimensions.
-                auto bb = calculateBoundingBox(sons);
-                double size = ceil((bb.getHeight() * bb.getWidth()) / 32.);
-                auto *bitMask = new uint32_t[(uint32_t) size]();
-
-                //the parent will contain the merged feature
-                parent->addToBitMask(bitMask, bb);
+                //nothing to merge
+                if (sons.size() == 1) {
+                    continue;
+                }
 
+                RegionMerge::mergeIntoParent(parent, sons);
                 for (auto son : sons) {
-                    if (son == parent) {
-                        continue;
+                    if (son != parent) {
+                        merged.insert(son);
                     }
-                    son->addToBitMask(bitMask, bb);
-                    parent->setCount(parent->getCount() + son->getCount());
-                    delete son; //we keep only the parent, we can delete the sons
-                    blobs->_blobs.remove(son);
                 }
-
-                delete[] parent->getFeature()->getBitMask();
-                delete parent->getFeature();
-                auto *feature = new Feature(parent->getTag(), bb, bitMask);
-
-                //For consistency, let's update redundant info
-                parent->setRowMin(bb.getUpperLeftRow());
-                parent->setRowMax(bb.getBottomRightRow());
-                parent->setColMin(bb.getUpperLeftCol());
-                parent->setColMax(bb.getBottomRightCol());
-
-                parent->setFeature(feature);
-            }
-        }
-
-        /**
-         * Calculate the tightest bounding box containing all the blobs individual bounding box.
-         * @param sons
-         * @return
-         */
-        BoundingBox calculateBoundingBox(std::set<Blob *> &sons) {
-
-            uint32_t upperLeftRow = std::numeric_limits<int32_t>::max(),
-                    upperLeftCol = std::numeric_limits<int32_t>::max(),
-                    bottomRightRow = 0,
-                    bottomRightCol = 0;
-
-            for (auto son : sons) {
-                auto bb = son->getFeature()->getBoundingBox();
-                upperLeftRow = (bb.getUpperLeftRow() < upperLeftRow) ? bb.getUpperLeftRow() : upperLeftRow;
-                upperLeftCol = (bb.getUpperLeftCol() < upperLeftCol) ? bb.getUpperLeftCol() : upperLeftCol;
-                bottomRightRow = (bb.getBottomRightRow() > bottomRightRow) ? bb.getBottomRightRow() : bottomRightRow;
-                bottomRightCol = bb.getBottomRightCol() > bottomRightCol ? bb.getBottomRightCol() : bottomRightCol;
             }
 
-            return BoundingBox(upperLeftRow, upperLeftCol, bottomRightRow, bottomRightCol);
+            blobs->_blobs.remove_if([&merged](Blob *blob) { return merged.count(blob) != 0; });
         }
 
-        uint32_t
-                _nbTiles = 0;                 ///< Images number of tiles
-
         std::map<Blob *, std::list<Coordinate >>
                 _toMerge{};                   ///< Merge structure
 
@@ -351,20 +302,26 @@ namespace egt {
 
         uint32_t imageWidth{}, imageHeight{};
 
-        std::map<Blob *, std::list<Coordinate >>
-                _holesToMerge{};                   ///< Merge structure
+        uint32_t tileHeight{}, tileWidth{};
+
+        std::chrono::milliseconds
+                _mergeDuration{};             ///< Time spent merging the blobs
 
         ListBlobs *
                 _holes{};                       ///< Holes list
 
-        uint32_t
-                _count = 0;                   ///< Number of views analysed
+        size_t
+                _nbHoles = 0,                   ///< Number of holes received
+                _nbObjects = 0;                 ///< Number of objects received
 
         SegmentationOptions* segmentationOptions{};
 
         EGTOptions *options{};
 
         DerivedSegmentationParams<T> &segmentationParams{};
+
+        uint32_t
+                _rootLevel{};                   ///< Merge level of the region covering the whole image
     };
 }
 
@@ -41,6 +41,7 @@
 #include <cstdint>
 #include <unordered_set>
 #include<egt/FeatureCollection/Data/Blob.h>
+#include <egt/FeatureCollection/Data/TileBitmap.h>
 #include <egt/utils/Utils.h>
 #include <egt/api/SegmentationOptions.h>
 #include <egt/api/DerivedSegmentationParams.h>
@@ -48,7 +49,8 @@
 #include <egt/FeatureCollection/Data/ViewOrViewAnalyse.h>
 #include <egt/api/DataTypes.h>
 #include <egt/data/GradientView.h>
-#include <egt/utils/FeatureExtraction.h>
+#include <egt/FeatureCollection/algorithms/runLengthLabeling.h>
+#include <egt/FeatureCollection/algorithms/floodFill.h>
 
 namespace egt {
 
@@ -64,6 +66,8 @@ namespace egt {
   * _4 (North, South, East, West)
   * _8 (North, North-East, North-West, South, South-East, South-West, East, West)
   * Blobs can represent Object (Foreground color) or Holes (Background color).
+  * Alternatively, tiles can be labeled with a run-based algorithm (Labeler::RUNS) : rows are scanned into runs
+  * that are united with a union-find. Both labelers produce the same ViewAnalyse.
   *
   * @tparam UserType File pixel type
   **/
@@ -83,7 +87,9 @@ namespace egt {
                 const uint8_t rank,
                 const UserType background,
                 SegmentationOptions* options,
-                DerivedSegmentationParams<UserType>& params
+                DerivedSegmentationParams<UserType>& params,
+                const Labeler labeler = Labeler::FLOOD,
+                const bool tileErode = false
                 )
                 : ITask<GradientView<UserType>, ViewOrViewAnalyse<UserType>>(numThreads),
                   _imageHeight(imageHeight),
@@ -94,8 +100,10 @@ namespace egt {
                   _background(background),
                   _segmentationOptions(options),
                   _segmentationParams(params),
+                  _labeler(labeler),
+                  _tileErode(tileErode),
                   _vAnalyse(nullptr) {
-            _visited = std::vector<bool>((unsigned long)(_tileWidth * _tileHeight), false);
+            _floodFill.reserve((unsigned long)(_tileWidth * _tileHeight));
         }
 
 
@@ -106,19 +114,25 @@ namespace egt {
             _view = view->getGradientView()->get();
             _originalView = view->getOriginalView();
             //FOR EACH NEW TILE WE NEED TO RESET THE TASK STATE SINCE MANY TILES CAN BE PROCESSED BY ONE TASK
-            _vAnalyse = new ViewAnalyse(); //OUTPUT
-            _toVisit.clear(); //clear queue that keeps track of neighbors to visit when flooding
-            _visited.assign(_visited.size(), false); //clear container that keeps track of all visited pixels in a pass through the image.
+            _vAnalyse = new ViewAnalyse(_view->getRow(), _view->getCol()); //OUTPUT
             _currentBlob = nullptr;
             _tileHeight = _view->getTileHeight();
             _tileWidth = _view->getTileWidth();
             _imageSize = _tileWidth * _tileHeight;
+            _visited.reset(_tileHeight, _tileWidth); //clear container that keeps track of all visited pixels in a pass through the image.
+            //threshold the tile and its halo once, both passes then only read 1 bit per pixel.
+            if (_tileErode) {
+                thresholdAndErode();
+            } else {
+                _foreground.reset(_tileHeight, _tileWidth);
+                _foreground.threshold(_view->getData(), _view->getViewWidth(), _view->getRadius(), _background);
+            }
 
             visitedCount = 0;
-            run(BACKGROUND); //find holes
+            label(BACKGROUND); //find holes
             auto backgroundPixelCount = visitedCount;
             visitedCount = 0;
-            run(FOREGROUND); //find objects
+            label(FOREGROUND); //find objects
             auto foregroundPixelCount = visitedCount;
             assert(_imageSize == backgroundPixelCount + foregroundPixelCount);
 
@@ -129,7 +143,7 @@ namespace egt {
                 VLOG(3) << "holes turned to foreground : " << holeRemovedCount;
                 VLOG(3) << "objects removed because too small: " << objectRemovedCount;
                 delete _vAnalyse;
-                delete view->getOriginalView();
+                view->releaseOriginalView();
                 this->addResult(new ViewOrViewAnalyse<UserType>(view->getGradientView()));
             }
             //we return a ViewAnalyse to be merged. Let's not forget to release the view since we are done with it.
@@ -139,8 +153,9 @@ namespace egt {
                 VLOG(3) << "objects removed because too small: " << objectRemovedCount;
                 VLOG(3) << "holes we keep track of in the merge: " << _vAnalyse->getHoles().size();
                 VLOG(3) << "holes to merge: " << _vAnalyse->getHolesToMerge().size();
-                VLOG(3) << "objects found: " << _vAnalyse->getBlobs().size();
+                VLOG(3) << "objects found: " << _vAnalyse->getBlobs().size() + _vAnalyse->getCompletedBlobs().size();
                 VLOG(3) << "objects to merge: " << _vAnalyse->getToMerge().size();
+                view->releaseOriginalView();
                 view->getGradientView()->releaseMemory();
                 this->addResult(new ViewOrViewAnalyse<UserType>(_vAnalyse));
             }
@@ -157,7 +172,9 @@ namespace egt {
                                                            _rank,
                                                            _background,
                                                            _segmentationOptions,
-                                                           _segmentationParams);
+                                                           _segmentationParams,
+                                                           _labeler,
+                                                           _tileErode);
             return viewAnalyzer;
         }
 
@@ -170,60 +187,190 @@ namespace egt {
 
     private:
 
-        void run(Color blobColor){
-//            printArray<UserType>("", _view->getData(), _view->getViewWidth(), _view->getViewHeight(), 4);
+        /**
+         * Threshold the tile with a 2 pixels halo and erode it, so the tile and its 1 pixel halo are eroded.
+         * Neighbor tiles compute the same eroded values for the pixels they share.
+         * Pixels outside the image do not erode the image border, as when eroding the features.
+         */
+        void thresholdAndErode() {
+            assert(_view->getRadius() >= 3);
+            auto rowBegin = -(int32_t) _view->getGlobalYOffset(),
+                    rowEnd = (int32_t) _imageHeight - (int32_t) _view->getGlobalYOffset(),
+                    colBegin = -(int32_t) _view->getGlobalXOffset(),
+                    colEnd = (int32_t) _imageWidth - (int32_t) _view->getGlobalXOffset();
+            _thresholded.reset(_tileHeight, _tileWidth, 2);
+            _thresholded.threshold(_view->getData(), _view->getViewWidth(), _view->getRadius(), _background);
+            _thresholded.fillOutside(rowBegin, rowEnd, colBegin, colEnd, true);
+            _foreground.erode(_thresholded);
+            _foreground.fillOutside(rowBegin, rowEnd, colBegin, colEnd, false);
+        }
+
+        void label(Color blobColor) {
+            if (_labeler == Labeler::RUNS) {
+                labelRuns(blobColor);
+            } else {
+                run(blobColor);
+            }
+        }
+
+        /**
+         * Label all the pixels of a color in a single pass over runs of pixels.
+         * Each component then goes through the same processing as a flooded blob.
+         * @param blobColor
+         */
+        void labelRuns(Color blobColor) {
+            auto xOffset = _view->getGlobalXOffset();
+            auto yOffset = _view->getGlobalYOffset();
+
+            //holes are 4-connected, objects are 8-connected.
+            auto nbComponents = _runLabeling.label(_tileHeight, _tileWidth, blobColor == FOREGROUND,
+                                                   [this, blobColor](int32_t row, int32_t col) {
+                                                       return getColor(row, col) == blobColor;
+                                                   });
 
-            for (int32_t row = 0; row < _tileHeight; ++row) {
-                for (int32_t col = 0; col < _tileWidth; ++col) {
+            std::vector<Blob *> blobs(nbComponents, nullptr);
 
-                    //WE ENTER HERE ONCE WE HAVE CREATED A BLOB THAT HAS NEIGHBORS OF THE SAME COLOR
-                    while (!_toVisit.empty()) {
-                        expandBlob(blobColor);
+            for (const auto &run : _runLabeling.getRuns()) {
+                auto &blob = blobs[run.label];
+                //runs come in raster order, so the first run gives the same starting pixel as the flood.
+                if (blob == nullptr) {
+                    blob = new Blob(yOffset + run.row, xOffset + run.colStart);
+                }
+                _currentBlob = blob;
+
+                for (auto col = run.colStart; col < run.colEnd; ++col) {
+                    markAsVisited(run.row, col);
+                }
+                _currentBlob->addRun(yOffset + run.row, xOffset + run.colStart, xOffset + run.colEnd);
+
+                if (_segmentationOptions->MASK_ONLY) {
+                    auto maskValue = (blobColor == FOREGROUND) ? 255 : 0;
+                    for (auto col = run.colStart; col < run.colEnd; ++col) {
+                        _view->setPixel(run.row, col, maskValue);
                     }
+                }
+
+                analyseRunBorders(run, blobColor);
+            }
 
-                    //WE ENTER HERE WHEN WE ARE DONE EXPANDING THE CURRENT BLOB
-                    if (_currentBlob != nullptr) {
-                        blobCompleted(blobColor);
+            for (auto blob : blobs) {
+                _currentBlob = blob;
+                blobCompleted(blobColor);
+            }
+        }
+
+        /// \brief Record the merge information of a run touching the tile borders.
+        /// \details Same rules as analyseNeighbour4 and analyseNeighbour8 : we record coordinates to merge
+        /// at EAST and SOUTH, and only flag the blob at WEST and NORTH.
+        /// \param run the run to analyse
+        /// \param color the run color
+        void analyseRunBorders(const LabeledRun &run, Color color) {
+
+            //WE DON'T NEED MERGING IF WE GENERATE ONLY THE MASK
+            if(_segmentationOptions->MASK_ONLY){
+                return;
+            }
+
+            auto globalRow = run.row + (int32_t)_view->getGlobalYOffset();
+            auto xOffset = (int32_t)_view->getGlobalXOffset();
+            bool eightConnectivity = (color == FOREGROUND);
+
+            bool onTileBottomBorder = (run.row + 1 == _tileHeight && globalRow + 1 != (int32_t) _imageHeight);
+            bool onTileTopBorder = (run.row == 0 && globalRow != 0);
+            bool onTileRightBorder = (run.colEnd == _tileWidth && xOffset + _tileWidth != (int32_t) _imageWidth);
+            bool onTileLeftBorder = (run.colStart == 0 && xOffset != 0);
+
+            if (onTileBottomBorder) {
+                for (auto col = run.colStart; col < run.colEnd; ++col) {
+                    if (getColor(run.row + 1, col) == color) {
+                        addRunToMerge(color, Coordinate(globalRow + 1, xOffset + col));
                     }
+                }
+            }
 
-                    //UNLESS WE ARE DONE EXPLORING WE CREATE A ONE PIXEL BLOB AND EXPLORE ITS NEIGHBORS
-                    if (!visited(row, col) && getColor(row, col) == blobColor) {
-                        createBlob(row,col, blobColor);
+            if (onTileTopBorder) {
+                for (auto col = run.colStart; col < run.colEnd; ++col) {
+                    if (getColor(run.row - 1, col) == color) {
+                        _currentBlob->setToMerge(true);
+                        break;
                     }
                 }
             }
 
-            //If the last pixel was a blob by itself, it has not been saved yet.
-            if (_currentBlob != nullptr) {
-                blobCompleted(blobColor);
+            if (onTileRightBorder) {
+                auto col = _tileWidth - 1;
+                auto globalCol = xOffset + col;
+                if (getColor(run.row, col + 1) == color) {
+                    addRunToMerge(color, Coordinate(globalRow, globalCol + 1));
+                }
+                if (eightConnectivity && onTileBottomBorder && getColor(run.row + 1, col + 1) == color) {
+                    addRunToMerge(color, Coordinate(globalRow + 1, globalCol + 1));
+                }
+                if (eightConnectivity && onTileTopBorder && getColor(run.row - 1, col + 1) == color) {
+                    addRunToMerge(color, Coordinate(globalRow - 1, globalCol + 1));
+                }
             }
-       }
 
-       /**
-        * We have a queue of pixels to visit. Dequeue the first one and explore its neighbors.
-        * @param blobColor
-        */
-        void expandBlob(Color blobColor){
-            auto neighbourCoord = *_toVisit.begin();
-            _toVisit.erase(_toVisit.begin());
-            //mark pixel as visited so we don't look at it again
-            markAsVisited(neighbourCoord.first,
-                          neighbourCoord.second);
+            if (onTileLeftBorder) {
+                if (getColor(run.row, - 1) == color) {
+                    _currentBlob->setToMerge(true);
+                }
+                if (eightConnectivity && onTileTopBorder && getColor(run.row - 1, - 1) == color) {
+                    _currentBlob->setToMerge(true);
+                }
+                if (eightConnectivity && onTileBottomBorder && getColor(run.row + 1, - 1) == color) {
+                    _currentBlob->setToMerge(true);
+                }
+            }
+        }
+
+        void addRunToMerge(Color color, const Coordinate &coords) {
+            if(color == BACKGROUND){
+                _vAnalyse->addHolesToMerge(_currentBlob, coords);
+            }
+            else {
+                _vAnalyse->addToMerge(_currentBlob, coords);
+            }
+            _currentBlob->setToMerge(true);
+        }
+
+        /**
+         * Label all the pixels of a color with a flood fill.
+         * @param blobColor
+         */
+        void run(Color blobColor){
+            //holes are 4-connected, objects are 8-connected.
+            _floodFill.fill(_tileHeight, _tileWidth, blobColor == FOREGROUND,
+                            [this, blobColor](int32_t row, int32_t col) {
+                                return !visited(row, col) && getColor(row, col) == blobColor;
+                            },
+                            [this](int32_t row, int32_t col) { markAsVisited(row, col); },
+                            [this](int32_t row, int32_t col) {
+                                //we are recording the global position
+                                _currentBlob = new Blob(_view->getGlobalYOffset() + row, _view->getGlobalXOffset() + col);
+                            },
+                            [this, blobColor](int32_t row, int32_t col) { addPixel(row, col, blobColor); },
+                            [this, blobColor]() { blobCompleted(blobColor); });
+        }
 
+        /**
+         * Add a flooded pixel to the current blob and look for its neighbors in the other tiles.
+         * @param row
+         * @param col
+         * @param blobColor
+         */
+        void addPixel(int32_t row, int32_t col, Color blobColor) {
             if(_segmentationOptions->MASK_ONLY){
-                auto maskValue = (getColor(neighbourCoord.first, neighbourCoord.second) == FOREGROUND) ? 255 : 0;
-                _view->setPixel(neighbourCoord.first,neighbourCoord.second, maskValue);
+                _view->setPixel(row, col, (blobColor == FOREGROUND) ? 255 : 0);
             }
 
-            _currentBlob->addPixel(
-                    _view->getGlobalYOffset() + neighbourCoord.first,
-                    _view->getGlobalXOffset() + neighbourCoord.second);
+            _currentBlob->addPixel(_view->getGlobalYOffset() + row, _view->getGlobalXOffset() + col);
 
             if (blobColor == BACKGROUND) {
-                analyseNeighbour4(neighbourCoord.first, neighbourCoord.second, blobColor);
+                analyseNeighbour4(row, col, blobColor);
             }
             else {
-                analyseNeighbour8(neighbourCoord.first, neighbourCoord.second, blobColor);
+                analyseNeighbour8(row, col, blobColor);
             }
         }
 
@@ -237,6 +384,10 @@ namespace egt {
                     //we know this hole is on the border, so we keep track of it for the merge.
                     if (_currentBlob->isToMerge()) {
                         if(!_segmentationOptions->MASK_ONLY) {
+                            //the merged hole mean intensity is computed from the partial sums of its blobs.
+                            if(!_segmentationOptions->disableIntensityFilter) {
+                                computeIntensitySum();
+                            }
                             _currentBlob->compactBlobDataIntoFeature();
                             _vAnalyse->insertHole(_currentBlob);
                         }
@@ -266,13 +417,11 @@ namespace egt {
                     if (!_currentBlob->isToMerge() && _currentBlob->getCount() < _segmentationOptions->MIN_OBJECT_SIZE) {
 
                         if(_segmentationOptions->MASK_ONLY){
-                            for (auto it = _currentBlob->getRowCols().begin();
-                                 it != _currentBlob->getRowCols().end(); ++it) {
-                                auto pRow = it->first;
-                                for (auto pCol : it->second) {
-                                    auto xOffset = _view->getGlobalXOffset();
-                                    auto yOffset = _view->getGlobalYOffset();
-                                    _view->setPixel(pRow - yOffset, pCol - xOffset,0);
+                            auto xOffset = _view->getGlobalXOffset();
+                            auto yOffset = _view->getGlobalYOffset();
+                            for (const auto &run : _currentBlob->getRuns()) {
+                                for (auto pCol = run.colStart; pCol < run.colEnd; ++pCol) {
+                                    _view->setPixel(run.row - yOffset, pCol - xOffset,0);
                                 }
                             }
                         }
@@ -283,7 +432,12 @@ namespace egt {
                     else{
                         if(!_segmentationOptions->MASK_ONLY) {
                             _currentBlob->compactBlobDataIntoFeature();
-                            _vAnalyse->insertBlob(_currentBlob);
+                            //objects not touching the tile border are complete, they are not merged.
+                            if (_currentBlob->isToMerge()) {
+                                _vAnalyse->insertBlob(_currentBlob);
+                            } else {
+                                _vAnalyse->insertCompletedBlob(_currentBlob);
+                            }
                         }
                     }
                 }
@@ -292,28 +446,8 @@ namespace egt {
         }
 
 
-        /**
-         * Create a new blob at a given position and try to expand it.
-         * @param row
-         * @param col
-         * @param blobColor
-         */
-        void createBlob(int32_t row, int32_t col, Color blobColor) {
-            markAsVisited(row, col);
-            //add pixel to a new blob (we are recording the global position)
-            _currentBlob = new Blob(_view->getGlobalYOffset() + row, _view->getGlobalXOffset() + col);
-            _currentBlob->addPixel(_view->getGlobalYOffset() + row, _view->getGlobalXOffset() + col);
-
-            //look at its neighbors
-            if (blobColor == BACKGROUND) {
-                analyseNeighbour4(row, col, blobColor);
-            }
-            else {
-                analyseNeighbour8(row, col, blobColor);
-            }
-        }
-
-        /// \brief Analyse the neighbour of a pixel for a 4-connectivity
+        /// \brief Analyse the neighbour of a pixel for a 4-connectivity.
+        /// \details Neighbors in the tile are flooded by the FloodFill, only the neighbors in the other tiles are looked at.
         /// \param row Pixel's row
         /// \param col Pixel's col
         void analyseNeighbour4(int32_t row, int32_t col, Color color) {
@@ -321,32 +455,6 @@ namespace egt {
             auto globalRow = row + _view->getGlobalYOffset();
             auto globalCol = col + _view->getGlobalXOffset();
 
-            //Explore neighbors in all directions to see if they need to be added to the blob.
-            //Top Pixel
-            if (row >= 1) {
-                if (!visited(row - 1, col) && getColor(row - 1, col) == color) {
-                    _toVisit.emplace(row - 1, col);
-                }
-            }
-            // Bottom pixel
-            if (row + 1 < _tileHeight) {
-                if (!visited(row + 1, col) && getColor(row + 1, col) == color) {
-                    _toVisit.emplace(row + 1, col);
-                }
-            }
-            // Left pixel
-            if (col >= 1) {
-                if (!visited(row, col - 1) && getColor(row, col - 1) == color) {
-                    _toVisit.emplace(row, col - 1);
-                }
-            }
-            // Right pixel
-            if ( (col + 1) < _tileWidth) {
-                if (!visited(row, col + 1) && getColor(row, col + 1) == color) {
-                    _toVisit.emplace(row, col + 1);
-                }
-            }
-
             //WE DON'T NEED MERGING IF WE GENERATE ONLY THE MASK
             if(_segmentationOptions->MASK_ONLY){
                 return;
@@ -402,23 +510,12 @@ namespace egt {
             }
         }
 
+        /// \brief Analyse the neighbour of a pixel for a 8-connectivity.
+        /// \details Neighbors in the tile are flooded by the FloodFill, only the neighbors in the other tiles are looked at.
+        /// \param row Pixel's row
+        /// \param col Pixel's col
         void analyseNeighbour8(int32_t row, int32_t col, Color color) {
 
-            // Analyse the pixels around the pixel
-            int32_t
-                    minRow = std::max(0, row - 1),
-                    maxRow = std::min(_view->getTileHeight(), row + 2),
-                    minCol = std::max(0, col - 1),
-                    maxCol = std::min(_view->getTileWidth(), col + 2);
-
-            for (int32_t rowP = minRow; rowP < maxRow; ++rowP) {
-                for (int32_t colP = minCol; colP < maxCol; ++colP) {
-                    if (!visited(rowP, colP)  && getColor(rowP, colP) == color) {
-                        _toVisit.emplace(rowP, colP);
-                    }
-                }
-            }
-
             //WE DON'T NEED MERGING IF WE GENERATE ONLY THE MASK
             if(_segmentationOptions->MASK_ONLY){
                 return;
@@ -529,21 +626,29 @@ namespace egt {
 
 
         /**
-         * @return the mean intensity for this blob.
+         * Record in the blob the sum of the original intensities of its pixels.
          */
-        UserType computeMeanIntensity() {
-            auto xOffset = _view->getGlobalXOffset();
-            auto yOffset = _view->getGlobalYOffset();
-            uint64_t sum = 0, count = 0;
-
-            for(const auto &entry : _currentBlob->getRowCols()) {
-                auto row = entry.first;
-                for(const auto col : entry.second) {
-                    sum += _originalView[(row - yOffset) * _tileWidth + (col - xOffset)];
-                    count ++;
+        void computeIntensitySum() {
+            auto xOffset = (int32_t)_view->getGlobalXOffset();
+            auto yOffset = (int32_t)_view->getGlobalYOffset();
+            uint64_t sum = 0;
+
+            for(const auto &run : _currentBlob->getRuns()) {
+                //runs are in image coordinates, the first pixel of the run is found in the tile before indexing
+                auto runStart = _originalView + (run.row - yOffset) * _tileWidth + (run.colStart - xOffset);
+                for(int32_t i = 0; i < run.colEnd - run.colStart; ++i) {
+                    sum += runStart[i];
                 }
             }
-            auto intensity = (UserType)(sum / count);
+            _currentBlob->setIntensitySum(sum);
+        }
+
+        /**
+         * @return the mean intensity for this blob.
+         */
+        UserType computeMeanIntensity() {
+            computeIntensitySum();
+            auto intensity = (UserType)(_currentBlob->getIntensitySum() / _currentBlob->getCount());
 
             VLOG(5) << "hole (" << _currentBlob->getTag()  << ") mean intensity "  << intensity;
 
@@ -554,14 +659,14 @@ namespace egt {
          * Set every pixel value to foreground and make sure those pixels are visited again in the object detection step.
          */
         void fillUpHole() {
-            for (auto it = _currentBlob->getRowCols().begin();
-                 it != _currentBlob->getRowCols().end(); ++it) {
-                auto pRow = it->first;
-                for (auto pCol : it->second) {
-                    auto xOffset = _view->getGlobalXOffset();
-                    auto yOffset = _view->getGlobalYOffset();
+            auto xOffset = _view->getGlobalXOffset();
+            auto yOffset = _view->getGlobalYOffset();
+            for (const auto &run : _currentBlob->getRuns()) {
+                auto pRow = run.row;
+                for (auto pCol = run.colStart; pCol < run.colEnd; ++pCol) {
 
                     markAsUnvisited(pRow - yOffset, pCol - xOffset);
+                    _foreground.set(pRow - yOffset, pCol - xOffset);
 
                     if (_segmentationOptions->MASK_ONLY) {
                         _view->setPixel(pRow - yOffset, pCol - xOffset, 255);
@@ -576,24 +681,21 @@ namespace egt {
 
 
         void markAsVisited(int32_t row, int32_t col) {
-            _visited[row * _tileWidth + col] = true;
+            _visited.set(row, col);
             visitedCount++;
         }
 
         void markAsUnvisited(int32_t row, int32_t col) {
-            _visited[row * _tileWidth + col] = false;
+            _visited.clear(row, col);
             visitedCount--;
         }
 
         inline bool visited(int32_t row, int32_t col){
-            return _visited[row * _tileWidth + col];
+            return _visited.test(row, col);
         }
 
-        Color getColor(int32_t row, int32_t col) {
-            if(_view->getPixel(row,col) > _background){
-                return Color::FOREGROUND;
-            }
-            return Color::BACKGROUND;
+        inline Color getColor(int32_t row, int32_t col) const {
+            return _foreground.test(row, col) ? Color::FOREGROUND : Color::BACKGROUND;
         }
 
 
@@ -604,8 +706,10 @@ namespace egt {
         const uint8_t _rank{}; ///< Rank to the connectivity: < 4=> 4-connectivity, 8=> 8-connectivity
 
 
-        std::vector<bool> _visited{}; ///keep track of every pixel we looked at.
-        std::set<Coordinate>_toVisit{}; /// for a current position, keep track of the neighbors that needs visit.
+        TileBitmap _visited{}; ///keep track of every pixel we looked at.
+        TileBitmap _foreground{}; ///pixels above the threshold, updated when holes are filled up.
+        TileBitmap _thresholded{}; ///pixels above the threshold with a 2 pixels halo, eroded into _foreground.
+        FloodFill _floodFill{}; ///< Flood fill stack, reused across tiles.
 
 
         Blob
@@ -627,6 +731,10 @@ namespace egt {
         SegmentationOptions* _segmentationOptions{};
         DerivedSegmentationParams<UserType> _segmentationParams{};
 
+        const Labeler _labeler = Labeler::FLOOD; ///< Labeling engine used to find the blobs.
+        const bool _tileErode = false; ///< Erode the thresholded tile before labeling it.
+        RunLengthLabeling _runLabeling{}; ///< Run-based labeling buffers, reused for each tile.
+
 
         ViewAnalyse *_vAnalyse = nullptr;         ///< Current view analyse
 
@@ -46,6 +46,7 @@
 #include <egt/FeatureCollection/Data/ViewAnalyse.h>
 #include <egt/FeatureCollection/Data/ViewOrViewAnalyse.h>
 #include <egt/api/DataTypes.h>
+#include <egt/FeatureCollection/algorithms/floodFill.h>
 
 
 namespace egt {
@@ -91,6 +92,7 @@ namespace egt {
                   _options(options),
                   _vAnalyse(nullptr) {
             _visited = std::vector<bool>((unsigned long)(_tileWidth * _tileHeight), false);
+            _floodFill.reserve((unsigned long)(_tileWidth * _tileHeight));
         }
 
 
@@ -100,8 +102,7 @@ namespace egt {
         override {
             _view = view->get();
             //FOR EACH NEW TILE WE NEED TO RESET THE TASK STATE SINCE MANY TILES CAN BE PROCESSED BY ONE TASK
-            _vAnalyse = new ViewAnalyse(); //OUTPUT
-            _toVisit.clear(); //clear queue that keeps track of neighbors to visit when flooding
+            _vAnalyse = new ViewAnalyse(_view->getRow(), _view->getCol()); //OUTPUT
             _visited.assign(_visited.size(), false); //clear container that keeps track of all visited pixels in a pass through the image.
             _currentBlob = nullptr;
             //TILE DIMENSION MIGHT CHANGE AND BE SMALLER, LET'S DO LESS WORK IF POSSIBLE
@@ -125,9 +126,9 @@ namespace egt {
                 VLOG(3) << "segmenting tile (" << _view->getRow() << " , " << _view->getCol() << ") :";
                 VLOG(3) << "holes turned to foreground : " << holeRemovedCount;
                 VLOG(3) << "objects removed because too small: " << objectRemovedCount;
-                VLOG(3) << "holes found: " << _vAnalyse->getHoles().size();
+                VLOG(3) << "holes found: " << _vAnalyse->getHoles().size() + _vAnalyse->getCompletedHoles().size();
                 VLOG(3) << "holes to merge: " << _vAnalyse->getHolesToMerge().size();
-                VLOG(3) << "objects found: " << _vAnalyse->getBlobs().size();
+                VLOG(3) << "objects found: " << _vAnalyse->getBlobs().size() + _vAnalyse->getCompletedBlobs().size();
                 VLOG(3) << "objects to merge: " << _vAnalyse->getToMerge().size();
                 view->releaseMemory();
                 this->addResult(new ViewOrViewAnalyse<UserType>(_vAnalyse));
@@ -158,57 +159,37 @@ namespace egt {
 
     private:
 
+        /**
+         * Label all the pixels of a color with a 4-connectivity flood fill.
+         * @param blobColor
+         */
         void run(Color blobColor){
-            for (int32_t row = 0; row < _tileHeight; ++row) {
-                for (int32_t col = 0; col < _tileWidth; ++col) {
-
-                    //WE ENTER HERE ONCE WE HAVE CREATED A BLOB THAT HAS NEIGHBORS OF THE SAME COLOR
-                    while (!_toVisit.empty()) {
-                        expandBlob(blobColor);
-                    }
-
-                    //WE ENTER HERE WHEN WE ARE DONE EXPANDING THE CURRENT BLOB
-                    if (_currentBlob != nullptr) {
-                        blobCompleted(blobColor);
-                    }
-
-                    //UNLESS WE ARE DONE EXPLORING WE CREATE A ONE PIXEL BLOB AND EXPLORE ITS NEIGHBORS
-                    if (!visited(row, col) && getColor(row, col) == blobColor) {
-                        createBlob(row,col, blobColor);
-                    }
-                }
-            }
-
-            //If the last pixel was a blob by itself, it has not been saved yet.
-            if (_currentBlob != nullptr) {
-                blobCompleted(blobColor);
-            }
+            _floodFill.fill(_tileHeight, _tileWidth, false,
+                            [this, blobColor](int32_t row, int32_t col) {
+                                return !visited(row, col) && getColor(row, col) == blobColor;
+                            },
+                            [this](int32_t row, int32_t col) { markAsVisited(row, col); },
+                            [this](int32_t row, int32_t col) {
+                                _currentBlob = new Blob(_view->getGlobalYOffset() + row, _view->getGlobalXOffset() + col);
+                            },
+                            [this, blobColor](int32_t row, int32_t col) { addPixel(row, col, blobColor); },
+                            [this, blobColor]() { blobCompleted(blobColor); });
        }
 
        /**
-        * We have a queue of pixels to visit. Take the first one and explore its neighbors as well.
+        * Add a flooded pixel to the current blob and look for its neighbors in the other tiles.
+        * @param row
+        * @param col
         * @param blobColor
         */
-        void expandBlob(Color blobColor){
-            auto neighbourCoord = *_toVisit.begin();
-            _toVisit.erase(_toVisit.begin());
-            //mark pixel as visited so we don't look at it again
-            markAsVisited(neighbourCoord.first,
-                          neighbourCoord.second);
-
+        void addPixel(int32_t row, int32_t col, Color blobColor){
             if(_options->MASK_ONLY){
-                auto maskValue = (getColor(neighbourCoord.first, neighbourCoord.second) == FOREGROUND) ? 255 : 0;
-                _view->setPixel(neighbourCoord.first,neighbourCoord.second, maskValue);
+                _view->setPixel(row, col, (blobColor == FOREGROUND) ? 255 : 0);
             }
 
-            _currentBlob->addPixel(
-                    _view->getGlobalYOffset() + neighbourCoord.first,
-                    _view->getGlobalXOffset() + neighbourCoord.second);
-
+            _currentBlob->addPixel(_view->getGlobalYOffset() + row, _view->getGlobalXOffset() + col);
 
-            if (_rank == 4) {
-                analyseNeighbour4(neighbourCoord.first, neighbourCoord.second, blobColor, true);
-            }
+            analyseNeighbour4(row, col, blobColor, true);
         }
 
         /**
@@ -225,12 +206,11 @@ namespace egt {
                     //we reset all pixels as UNVISITED foreground.
                     if ( (_currentBlob->getCount() < _options->MIN_HOLE_SIZE) && !_currentBlob->isToMerge()) {
 
-                        for (auto it = _currentBlob->getRowCols().begin();
-                             it != _currentBlob->getRowCols().end(); ++it) {
-                            auto pRow = it->first;
-                            for (auto pCol : it->second) {
-                                auto xOffset = _view->getGlobalXOffset();
-                                auto yOffset = _view->getGlobalYOffset();
+                        auto xOffset = _view->getGlobalXOffset();
+                        auto yOffset = _view->getGlobalYOffset();
+                        for (const auto &run : _currentBlob->getRuns()) {
+                            auto pRow = run.row;
+                            for (auto pCol = run.colStart; pCol < run.colEnd; ++pCol) {
 
                                 markAsUnvisited(pRow - yOffset, pCol - xOffset);
 
@@ -250,7 +230,11 @@ namespace egt {
                         //WE ADD IT
                         if(!_options->MASK_ONLY) {
                             _currentBlob->compactBlobDataIntoFeature();
-                            _vAnalyse->insertHole(_currentBlob);
+                            if (_currentBlob->isToMerge()) {
+                                _vAnalyse->insertHole(_currentBlob);
+                            } else {
+                                _vAnalyse->insertCompletedHole(_currentBlob);
+                            }
                         }
                     }
 
@@ -260,13 +244,11 @@ namespace egt {
                     if (_currentBlob->getCount() < _options->MIN_OBJECT_SIZE && !_currentBlob->isToMerge()) {
 
                         if(_options->MASK_ONLY){
-                            for (auto it = _currentBlob->getRowCols().begin();
-                                 it != _currentBlob->getRowCols().end(); ++it) {
-                                auto pRow = it->first;
-                                for (auto pCol : it->second) {
-                                    auto xOffset = _view->getGlobalXOffset();
-                                    auto yOffset = _view->getGlobalYOffset();
-                                    _view->setPixel(pRow - yOffset, pCol - xOffset,0);
+                            auto xOffset = _view->getGlobalXOffset();
+                            auto yOffset = _view->getGlobalYOffset();
+                            for (const auto &run : _currentBlob->getRuns()) {
+                                for (auto pCol = run.colStart; pCol < run.colEnd; ++pCol) {
+                                    _view->setPixel(run.row - yOffset, pCol - xOffset,0);
                                 }
                             }
                         }
@@ -278,7 +260,11 @@ namespace egt {
                         //WE ADD IT
                         if(!_options->MASK_ONLY) {
                             _currentBlob->compactBlobDataIntoFeature();
-                            _vAnalyse->insertBlob(_currentBlob);
+                            if (_currentBlob->isToMerge()) {
+                                _vAnalyse->insertBlob(_currentBlob);
+                            } else {
+                                _vAnalyse->insertCompletedBlob(_currentBlob);
+                            }
                         }
                     }
                 }
@@ -287,26 +273,8 @@ namespace egt {
         }
 
 
-        /**
-         * Create a new blob at this pixel and check its neighbors to kickstart its expansion.
-         * @param row
-         * @param col
-         * @param blobColor
-         */
-        void createBlob(int32_t row, int32_t col, Color blobColor){
-            markAsVisited(row, col);
-            //add pixel to a new blob
-            _currentBlob = new Blob(_view->getGlobalYOffset() + row, _view->getGlobalXOffset() + col);
-            _currentBlob->addPixel(_view->getGlobalYOffset() + row, _view->getGlobalXOffset() + col);
-            //make sure we don't look at it again
-
-            //look at its neighbors
-            if (_rank == 4) {
-                analyseNeighbour4(row, col, blobColor, true);
-            }
-        }
-
-        /// \brief Analyse the neighbour of a pixel for a 4-connectivity
+        /// \brief Analyse the neighbour of a pixel for a 4-connectivity.
+        /// \details Neighbors in the tile are flooded by the FloodFill, only the neighbors in the other tiles are looked at.
         /// \param row Pixel's row
         /// \param col Pixel's col
         void analyseNeighbour4(int32_t row, int32_t col, Color color,bool erode) {
@@ -314,32 +282,6 @@ namespace egt {
             auto globalRow = row + _view->getGlobalYOffset();
             auto globalCol = col + _view->getGlobalXOffset();
 
-            //Explore neighbors in all directions to see if they need to be added to the blob.
-            //Top Pixel
-            if (row >= 1) {
-                if (!visited(row - 1, col) && getColor(row - 1, col) == color) {
-                    _toVisit.emplace(row - 1, col);
-                }
-            }
-            // Bottom pixel
-            if (row + 1 < _tileHeight) {
-                if (!visited(row + 1, col) && getColor(row + 1, col) == color) {
-                    _toVisit.emplace(row + 1, col);
-                }
-            }
-            // Left pixel
-            if (col >= 1) {
-                if (!visited(row, col - 1) && getColor(row, col - 1) == color) {
-                    _toVisit.emplace(row, col - 1);
-                }
-            }
-            // Right pixel
-            if ( (col + 1) < _tileWidth) {
-                if (!visited(row, col + 1) && getColor(row, col + 1) == color) {
-                    _toVisit.emplace(row, col + 1);
-                }
-            }
-
             //WE DON'T NEED MERGING IF WE GENERATE ONLY THE MASK
             if(_options->MASK_ONLY){
                 return;
@@ -423,7 +365,7 @@ namespace egt {
 
 
         std::vector<bool> _visited{}; ///keep track of every pixel we looked at.
-        std::set<Coordinate>_toVisit{}; /// for a current position, keep track of the neighbors that needs visit.
+        FloodFill _floodFill{}; ///< Flood fill stack, reused across tiles.
 
 
         Blob
@@ -45,7 +45,14 @@
 #include <FastImage/FeatureCollection/Tasks/ViewAnalyser.h>
 #include <egt/FeatureCollection/Data/Blob.h>
 #include <egt/FeatureCollection/Data/ListBlobs.h>
-#include <egt/FeatureCollection/Tasks/BlobMerger.h>
+#include <egt/FeatureCollection/Tasks/MaskTileScheduler.h>
+#include <egt/FeatureCollection/Tasks/MaskTileRasterizer.h>
+#include <egt/FeatureCollection/Tasks/MaskTileEncoder.h>
+#include <egt/FeatureCollection/Tasks/OrderedMaskWriter.h>
+#include <egt/memory/TileAllocator.h>
+#include <egt/utils/TiffTileEncoder.h>
+#include <htgs/api/TaskGraphConf.hpp>
+#include <htgs/api/TaskGraphRuntime.hpp>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgcodecs.hpp>
 //#include <libltdl/lt_system.h>
@@ -270,411 +277,205 @@ class FeatureCollection {
     return answer;
   }
 
-  /// \brief Create a tiled tiff mask, where the pixels are the feature id.
+  /// \brief Create a tiled tiff mask, where the pixels are the feature id + 1.
+  /// \details The mask is written one band of tile rows at a time, see writeMaskBands.
   /// \param pathLabeledMask Path to save the mask.
   /// \param tileSize Size of tile in the tiff image
+  /// \param compression Tile compression
   void createLabeledMask(const std::string &pathLabeledMask,
-                         const uint32_t tileSize = 1024) {
-    if ((tileSize & (tileSize - 1)) != 0) {
-      std::stringstream message;
-      message
-          << "Feature Collection ERROR: The tiling asked is not a power of 2.";
-      std::string m = message.str();
-      throw (fi::FastImageException(m));
-    }
-    // Get image size
-    auto
-        imageWidth = this->getImageWidth(),
-        imageHeight = this->getImageHeight();
-
-    // Create two tiles pointer: one empty, one to be filled
-    std::vector<uint32_t >
-        *emptyTile = new std::vector<uint32_t>(tileSize * tileSize, 0),
-        *currentTile = nullptr;
-
-    // Create a pair to create a coordinate (row/col)
-    std::pair<uint32_t, uint32_t>
-        currentCoordinates;
-
-    // Create the tiff file
-    TIFF
-        *tif = TIFFOpen(pathLabeledMask.c_str(), "w");
-
-    uint32_t
-        upperLeftRowFeature = 0,
-        upperLeftColFeature = 0,
-        bottomRightRowFeature = 0,
-        bottomRightColFeature = 0,
-        minRowTile = 0,
-        minColTile = 0,
-        upperLeftRow = 0,
-        upperLeftCol = 0,
-        bottomRightRow = 0,
-        bottomRightCol = 0,
-        indexMinTileRow = 0,
-        indexMaxTileRow = 0,
-        indexMinTileCol = 0,
-        indexMaxTileCol = 0;
-
-    // Create a map of coordinate -> Tile
-    std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t> *>
-        loadedTiles;
-
-    if (tif != nullptr) {
-      TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, imageWidth);
-      TIFFSetField(tif, TIFFTAG_IMAGELENGTH, imageHeight);
-      TIFFSetField(tif, TIFFTAG_TILELENGTH, tileSize);
-      TIFFSetField(tif, TIFFTAG_TILEWIDTH, tileSize);
-      TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8 * sizeof(uint32_t));
-      TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, 1);
-      TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
-      TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
-      TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-      TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
-      TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-      TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-
-      // For every feature in the feature collection
-      for (const auto &feature : this->getVectorFeatures()) {
-        // Get the bounding box
-        upperLeftRowFeature = feature.getBoundingBox().getUpperLeftRow();
-        upperLeftColFeature = feature.getBoundingBox().getUpperLeftCol();
-        bottomRightRowFeature = feature.getBoundingBox().getBottomRightRow();
-        bottomRightColFeature = feature.getBoundingBox().getBottomRightCol();
-
-        indexMinTileRow = upperLeftRowFeature / tileSize;
-        indexMinTileCol = upperLeftColFeature / tileSize;
-
-        indexMaxTileRow = (bottomRightRowFeature - 1) / tileSize;
-        indexMaxTileCol = (bottomRightColFeature - 1) / tileSize;
-
-        // For every view in the bounding box
-        for (uint32_t indexRow = indexMinTileRow; indexRow <= indexMaxTileRow;
-             ++indexRow) {
-          for (uint32_t indexCol = indexMinTileCol; indexCol <= indexMaxTileCol;
-               ++indexCol) {
-
-            // Get the tile, from the map or create one
-            currentCoordinates =
-                std::pair<uint32_t, uint32_t>(indexRow, indexCol);
-            if (loadedTiles.find(currentCoordinates) == loadedTiles.end()) {
-              loadedTiles[currentCoordinates] =
-                  new std::vector<uint32_t>(tileSize * tileSize, 0);
-            }
-            currentTile = loadedTiles[currentCoordinates];
-
-            // Get the indexes used for the computation
-            minRowTile = indexRow * tileSize;
-            minColTile = indexCol * tileSize;
-
-            upperLeftRow = std::max(minRowTile, upperLeftRowFeature);
-            upperLeftCol = std::max(minColTile, upperLeftColFeature);
-
-            bottomRightRow =
-                std::min(bottomRightRowFeature, (indexRow + 1) * tileSize);
-            bottomRightCol =
-                std::min(bottomRightColFeature, (indexCol + 1) * tileSize);
-
-            // For every pixel in the tile
-            for (uint32_t rowTileFeature = upperLeftRow;
-                 rowTileFeature < bottomRightRow; ++rowTileFeature) {
-              for (uint32_t colTileFeature = upperLeftCol;
-                   colTileFeature < bottomRightCol; ++colTileFeature) {
-
-                // If the pixel is in the feature
-                if (feature.isImagePixelInBitMask(rowTileFeature, colTileFeature)) {
-                  currentTile->at((rowTileFeature - minRowTile) * tileSize
-                                      + (colTileFeature - minColTile))
-                      = (uint32_t) (feature.getId() + 1);
-                }
-              }
-            }
-          }
-        }
-      }
-
-      indexMaxTileRow = (this->getImageHeight() - 1) / tileSize;
-      indexMaxTileCol = (this->getImageWidth() - 1) / tileSize;
-
-      // For every tile in the image
-      for (uint32_t indexRow = 0; indexRow <= indexMaxTileRow; indexRow++) {
-        for (uint32_t indexCol = 0; indexCol <= indexMaxTileCol; indexCol++) {
-
-          // Get the tile from it coordinates in the map
-          currentCoordinates =
-              std::pair<uint32_t, uint32_t>(indexRow, indexCol);
-          // If it doesn't exist write the blank tile
-          if (loadedTiles.find(currentCoordinates) == loadedTiles.end()) {
-            TIFFWriteTile(tif,
-                          emptyTile->data(),
-                          indexCol * tileSize,
-                          indexRow * tileSize,
-                          0,
-                          0);
-          } else {
-            // Write the filled tile
-            TIFFWriteTile(tif,
-                          loadedTiles[currentCoordinates]->data(),
-                          indexCol * tileSize,
-                          indexRow * tileSize,
-                          0,
-                          0);
-          }
-
-        }
-      }
-      // Close the tif
-      TIFFClose(tif);
-    } else {
-      std::cerr << "The File " << pathLabeledMask << " can't be opened."
-                << std::endl;
-      exit(1);
-    }
-
-    delete emptyTile;
-    for (auto &tile : loadedTiles) {
-      delete tile.second;
-    }
+                         const uint32_t tileSize = 1024,
+                         MaskCompression compression = MaskCompression::NONE) {
+    writeMaskBands<uint32_t>(pathLabeledMask, tileSize, 8 * sizeof(uint32_t), true, compression);
   }
 
 
-  /// \brief Create a tiled tiff mask, where the pixels are 1.
+  /// \brief Create a tiled tiff mask, where the pixels are 255.
+  /// \details The mask is written one band of tile rows at a time, see writeMaskBands.
+  /// A mask compressed with packbits is written with 1 bit per pixel.
   /// \param pathLabeledMask Path to save the mask.
   /// \param tileSize Size of tile in the tiff image
+  /// \param compression Tile compression
   void createBlackWhiteMask(const std::string &pathLabeledMask,
-                            const uint32_t tileSize = 1024) {
-    if ((tileSize & (tileSize - 1)) != 0) {
-      std::stringstream message;
-      message
-          << "Feature Collection ERROR: The tiling asked is not a power of 2.";
-      std::string m = message.str();
-      throw (fi::FastImageException(m));
+                            const uint32_t tileSize = 1024,
+                            MaskCompression compression = MaskCompression::NONE) {
+    writeMaskBands<uint8_t>(pathLabeledMask, tileSize, blackWhiteBitsPerSample(compression), false, compression);
+  }
+
+
+    /// \brief Create a tiled tiff mask, where the pixels are 255.
+    /// \details Tiles are rasterized and compressed in parallel from the features intersecting them, and written in
+    /// order. A mask compressed with packbits is written with 1 bit per pixel.
+    /// \param pathLabeledMask Path to save the mask.
+    /// \param tileSize Size of tile in the tiff image
+    /// \param nbThreads Number of threads rasterizing and compressing tiles
+    /// \param compression Tile compression
+    /// \param nbPyramidLevels Number of reduced resolution levels written as sub-IFDs
+    void createBlackWhiteMaskStreaming(const std::string &pathLabeledMask,
+                              const uint32_t tileSize = 1024, uint32_t nbThreads = 1,
+                              MaskCompression compression = MaskCompression::NONE, uint32_t nbPyramidLevels = 0) {
+      writeMaskStreaming<uint8_t>(pathLabeledMask, tileSize, blackWhiteBitsPerSample(compression), false, nbThreads,
+                                  compression, nbPyramidLevels);
     }
-    // Get image size
-    auto
-        imageWidth = this->getImageWidth(),
-        imageHeight = this->getImageHeight();
 
-    // Create two tiles pointer: one empty, one to be filled
-    std::vector<uint8_t>
-        *emptyTile = new std::vector<uint8_t>(tileSize * tileSize, 0),
-        *currentTile = nullptr;
 
-    // Create a pair to create a coordinate (row/col)
-    std::pair<uint32_t, uint32_t>
-        currentCoordinates;
+    /// \brief Create a tiled tiff mask, where the pixels are the feature id + 1.
+    /// \details Tiles are rasterized and compressed in parallel from the features intersecting them, and written in
+    /// order.
+    /// \param pathLabeledMask Path to save the mask.
+    /// \param tileSize Size of tile in the tiff image
+    /// \param depth Depth of the mask pixels
+    /// \param nbThreads Number of threads rasterizing and compressing tiles
+    /// \param compression Tile compression
+    /// \param nbPyramidLevels Number of reduced resolution levels written as sub-IFDs
+    template <class T>
+    void createLabeledMaskStreaming(const std::string &pathLabeledMask, const uint32_t tileSize = 1024,
+                                    ImageDepth depth = ImageDepth::_8U, uint32_t nbThreads = 1,
+                                    MaskCompression compression = MaskCompression::NONE,
+                                    uint32_t nbPyramidLevels = 0) {
 
-    // Create the tiff file
-    TIFF
-        *tif = TIFFOpen(pathLabeledMask.c_str(), "w");
+      uint32_t resolution = 0;
 
-    uint32_t
-        upperLeftRowFeature = 0,
-        upperLeftColFeature = 0,
-        bottomRightRowFeature = 0,
-        bottomRightColFeature = 0,
-        minRowTile = 0,
-        minColTile = 0,
-        upperLeftRow = 0,
-        upperLeftCol = 0,
-        bottomRightRow = 0,
-        bottomRightCol = 0,
-        indexMinTileRow = 0,
-        indexMaxTileRow = 0,
-        indexMinTileCol = 0,
-        indexMaxTileCol = 0;
-
-    // Create a map of coordinate -> Tile
-    std::map<std::pair<uint32_t, uint32_t>, std::vector<uint8_t> *>
-        loadedTiles;
-
-    if (tif != nullptr) {
-      TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, imageWidth);
-      TIFFSetField(tif, TIFFTAG_IMAGELENGTH, imageHeight);
-      TIFFSetField(tif, TIFFTAG_TILELENGTH, tileSize);
-      TIFFSetField(tif, TIFFTAG_TILEWIDTH, tileSize);
-      TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8 * sizeof(uint8_t));
-      TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, 1);
-      TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
-      TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
-      TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-      TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
-      TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-      TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-
-      // For every feature in the feature collection
-      for (const auto &feature : this->getVectorFeatures()) {
-
-        // Get the bounding box
-        upperLeftRowFeature = feature.getBoundingBox().getUpperLeftRow();
-        upperLeftColFeature = feature.getBoundingBox().getUpperLeftCol();
-        bottomRightRowFeature = feature.getBoundingBox().getBottomRightRow();
-        bottomRightColFeature = feature.getBoundingBox().getBottomRightCol();
-
-        indexMinTileRow = upperLeftRowFeature / tileSize;
-        indexMinTileCol = upperLeftColFeature / tileSize;
-
-        indexMaxTileRow = (bottomRightRowFeature - 1) / tileSize;
-        indexMaxTileCol = (bottomRightColFeature - 1) / tileSize;
-
-        // For every view in the bounding box
-        for (uint32_t indexRow = indexMinTileRow; indexRow <= indexMaxTileRow;
-             ++indexRow) {
-          for (uint32_t indexCol = indexMinTileCol; indexCol <= indexMaxTileCol;
-               ++indexCol) {
-
-            // Get the tile, from the map or create one
-            currentCoordinates =
-                std::pair<uint32_t, uint32_t>(indexRow, indexCol);
-            if (loadedTiles.find(currentCoordinates) == loadedTiles.end()) {
-              loadedTiles[currentCoordinates] =
-                  new std::vector<uint8_t>(tileSize * tileSize, 0);
-            }
-            currentTile = loadedTiles[currentCoordinates];
-
-            // Get the indexes used for the computation
-            minRowTile = indexRow * tileSize;
-            minColTile = indexCol * tileSize;
-
-            upperLeftRow = std::max(minRowTile, upperLeftRowFeature);
-            upperLeftCol = std::max(minColTile, upperLeftColFeature);
-
-            bottomRightRow =
-                std::min(bottomRightRowFeature, (indexRow + 1) * tileSize);
-            bottomRightCol =
-                std::min(bottomRightColFeature, (indexCol + 1) * tileSize);
-
-            // For every pixel in the tile
-            for (uint32_t rowTileFeature = upperLeftRow;
-                 rowTileFeature < bottomRightRow; ++rowTileFeature) {
-              for (uint32_t colTileFeature = upperLeftCol;
-                   colTileFeature < bottomRightCol; ++colTileFeature) {
-
-                // If the pixel is in the feature
-                if (feature.isImagePixelInBitMask(rowTileFeature, colTileFeature)) {
-                  currentTile->at((rowTileFeature - minRowTile) * tileSize
-                                      + (colTileFeature - minColTile)) = 255;
-                }
-              }
-            }
+      switch (depth){
+          case ImageDepth::_8U : {
+            resolution = 8 * sizeof(uint8_t);
+            break;
           }
-        }
-      }
-
-      indexMaxTileRow = (this->getImageHeight() - 1) / tileSize;
-      indexMaxTileCol = (this->getImageWidth() - 1) / tileSize;
-
-      // For every tile in the image
-      for (uint32_t indexRow = 0; indexRow <= indexMaxTileRow; indexRow++) {
-        for (uint32_t indexCol = 0; indexCol <= indexMaxTileCol; indexCol++) {
-
-          // Get the tile from it coordinates in the map
-          currentCoordinates =
-              std::pair<uint32_t, uint32_t>(indexRow, indexCol);
-          // If it doesn't exist write the blank tile
-          if (loadedTiles.find(currentCoordinates) == loadedTiles.end()) {
-
-            TIFFWriteTile(tif,
-                          emptyTile->data(),
-                          indexCol * tileSize,
-                          indexRow * tileSize,
-                          0,
-                          0);
-          } else {
-            // Write the filled tile
-            TIFFWriteTile(tif,
-                          (loadedTiles[currentCoordinates])->data(),
-                          indexCol * tileSize,
-                          indexRow * tileSize,
-                          0,
-                          0);
+          case ImageDepth::_16U : {
+            resolution = 8 * sizeof(uint16_t);
+            break;
+          }
+          case ImageDepth::_32U : {
+            resolution = 8 * sizeof(uint32_t);
+            break;
           }
-
-        }
       }
-      // Close the tif
-      TIFFClose(tif);
-    } else {
-      std::cerr << "The File " << pathLabeledMask << " can't be opened."
-                << std::endl;
-      exit(1);
-    }
 
-    delete emptyTile;
-    for (auto &tile : loadedTiles) {
-      delete tile.second;
+      writeMaskStreaming<T>(pathLabeledMask, tileSize, resolution, true, nbThreads, compression, nbPyramidLevels);
     }
-  }
 
 
-    /// \brief Create a tiled tiff mask, where the pixels are 1.
+ private:
+
+    /// \return Number of bits per pixel of a black and white mask
+    static uint16_t blackWhiteBitsPerSample(MaskCompression compression) {
+      return compression == MaskCompression::PACKBITS ? 1 : 8 * sizeof(uint8_t);
+    }
+
+    /// \brief Create a tiled tiff mask, one band of tile rows at a time.
+    /// \details Features are sorted by the first tile row they cross. Each band rasterizes the features crossing it,
+    /// copying their bitmask rows into the band tiles, then writes and clears its tiles before the next band. The
+    /// memory used is bounded by a band: image width x tile size x pixel depth. Empty tiles are encoded once.
     /// \param pathLabeledMask Path to save the mask.
     /// \param tileSize Size of tile in the tiff image
-    void createBlackWhiteMaskStreaming(const std::string &pathLabeledMask,
-                              const uint32_t tileSize = 1024) {
+    /// \param bitsPerSample Number of bits per pixel in the tiff image
+    /// \param labeled True to write the feature id + 1, false to write 255
+    /// \param compression Tile compression
+    template <class T>
+    void writeMaskBands(const std::string &pathLabeledMask, uint32_t tileSize, uint16_t bitsPerSample,
+                        bool labeled, MaskCompression compression) {
       if ((tileSize & (tileSize - 1)) != 0) {
         std::stringstream message;
         message
-                << "Feature Collection ERROR: The tiling asked is not a power of 2.";
+            << "Feature Collection ERROR: The tiling asked is not a power of 2.";
         std::string m = message.str();
         throw (fi::FastImageException(m));
       }
       // Get image size
       auto
-              imageWidth = this->getImageWidth(),
-              imageHeight = this->getImageHeight();
-
-      VLOG(4) << "writing bitmask";
+          imageWidth = this->getImageWidth(),
+          imageHeight = this->getImageHeight();
 
       // Create the tiff file
       TIFF
-              *tif = TIFFOpen(pathLabeledMask.c_str(), "w");
+          *tif = TIFFOpen(pathLabeledMask.c_str(), "w");
 
       if (tif != nullptr) {
-        TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, imageWidth);
-        TIFFSetField(tif, TIFFTAG_IMAGELENGTH, imageHeight);
-        TIFFSetField(tif, TIFFTAG_TILELENGTH, tileSize);
-        TIFFSetField(tif, TIFFTAG_TILEWIDTH, tileSize);
-        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8 * sizeof(uint8_t));
-        TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, 1);
-        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
-        TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
-        TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
-        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-        TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-
-        auto maxTileCol = (uint32_t)std::ceil((double)this->_imageWidth / tileSize);
-        auto maxTileRow = (uint32_t)std::ceil((double)this->_imageWidth / tileSize);
-
-        for(uint32_t tileRow = 0 ; tileRow < maxTileRow ; tileRow++){
-          for(uint32_t tileCol = 0; tileCol < maxTileCol; tileCol++){
-
-            auto tile = std::vector<uint8_t>(tileSize * tileSize, 0);
-
-            for(uint32_t j = 0; j < tileSize; j++){
-              for(uint32_t i = 0; i < tileSize; i++){
-                auto f = getFeatureFromPixel(tileRow * tileSize + j, tileCol * tileSize + i);
-                if(f != nullptr) {
-                    tile[j* tileSize + i] = 255;
-                }
+        auto
+            nbTileRows = (imageHeight + tileSize - 1) / tileSize,
+            nbTileCols = (imageWidth + tileSize - 1) / tileSize;
+        auto tileArea = (size_t) tileSize * tileSize;
+
+        TiffTileEncoder encoder(tileSize, bitsPerSample, compression);
+        TiffTileEncoder::setTags(tif, imageWidth, imageHeight, tileSize, bitsPerSample, compression);
+        //the empty tile is encoded once for the whole mask
+        std::vector<T> band(tileArea, 0);
+        auto encodedEmptyTile = encoder.encode(band.data());
+
+        // The tiles of a band, side by side, and whether a feature touched them
+        band.assign(tileArea * nbTileCols, 0);
+        std::vector<bool> touched(nbTileCols, false);
+
+        // The features, by first tile row
+        std::vector<const Feature *> sortedFeatures;
+        sortedFeatures.reserve(_vectorFeatures.size());
+        for (const auto &feature : _vectorFeatures) {
+          if (feature.getBoundingBox().getHeight() > 0 && feature.getBoundingBox().getWidth() > 0) {
+            sortedFeatures.push_back(&feature);
+          }
+        }
+        std::sort(sortedFeatures.begin(), sortedFeatures.end(), [](const Feature *a, const Feature *b) {
+          return a->getBoundingBox().getUpperLeftRow() < b->getBoundingBox().getUpperLeftRow();
+        });
+        auto nextFeature = sortedFeatures.begin();
+        std::vector<const Feature *> activeFeatures;
+
+        for (uint32_t tileRow = 0; tileRow < nbTileRows; ++tileRow) {
+          auto bandRowMin = tileRow * tileSize,
+              bandRowMax = std::min(bandRowMin + tileSize, imageHeight);
+
+          // Features starting in this band join the ones crossing it from above
+          while (nextFeature != sortedFeatures.end()
+              && (*nextFeature)->getBoundingBox().getUpperLeftRow() < bandRowMax) {
+            activeFeatures.push_back(*nextFeature);
+            ++nextFeature;
+          }
+
+          for (auto feature : activeFeatures) {
+            const auto &bb = feature->getBoundingBox();
+            auto value = labeled ? (T) (feature->getId() + 1) : (T) 255;
+            auto rowBegin = std::max(bb.getUpperLeftRow(), bandRowMin),
+                rowEnd = std::min(bb.getBottomRightRow(), bandRowMax);
+            auto colEnd = std::min(bb.getBottomRightCol(), imageWidth);
+
+            for (auto col = bb.getUpperLeftCol(); col < colEnd; col = (col / tileSize + 1) * tileSize) {
+              auto tileCol = col / tileSize;
+              auto runEnd = std::min(colEnd, (tileCol + 1) * tileSize);
+              T *tile = band.data() + tileCol * tileArea;
+              touched[tileCol] = true;
+              for (auto row = rowBegin; row < rowEnd; ++row) {
+                auto pos = (uint64_t) (row - bb.getUpperLeftRow()) * bb.getWidth() + (col - bb.getUpperLeftCol());
+                BitmaskAlgorithms::bitRunToArray(feature->getBitMask(), pos, runEnd - col,
+                                                 tile + (size_t) (row - bandRowMin) * tileSize
+                                                 + (col - tileCol * tileSize),
+                                                 value);
               }
             }
+          }
 
-            TIFFWriteTile(tif,
-                          (tdata_t)tile.data(),
-                          tileCol * tileSize,
-                          tileRow * tileSize,
-                          0,
-                          0);
-
-            VLOG(4) << "done writing tile (" << tileRow << "," << tileCol << ")";
-
+          // Features ending in this band are done
+          activeFeatures.erase(std::remove_if(activeFeatures.begin(), activeFeatures.end(),
+                                              [bandRowMax](const Feature *feature) {
+                                                return feature->getBoundingBox().getBottomRightRow() <= bandRowMax;
+                                              }),
+                               activeFeatures.end());
+
+          for (uint32_t tileCol = 0; tileCol < nbTileCols; ++tileCol) {
+            if (touched[tileCol]) {
+              T *tile = band.data() + tileCol * tileArea;
+              encoder.write(tif, tile, tileRow, tileCol);
+              std::fill_n(tile, tileArea, 0);
+              touched[tileCol] = false;
+            } else {
+              TIFFWriteRawTile(tif,
+                               TIFFComputeTile(tif, tileCol * tileSize, tileRow * tileSize, 0, 0),
+                               encodedEmptyTile.data(),
+                               (tmsize_t) encodedEmptyTile.size());
+            }
           }
         }
 
+        // Close the tif
         TIFFClose(tif);
-          VLOG(4) << "done writing mask : " << pathLabeledMask.c_str();
       } else {
         std::cerr << "The File " << pathLabeledMask << " can't be opened."
                   << std::endl;
@@ -682,30 +483,76 @@ class FeatureCollection {
       }
     }
 
-
-    /// \brief Create a tiled tiff mask, where the pixels are 1.
-    /// \param pathLabeledMask Path to save the mask.
+    /// \brief Layout of the resolution levels of a mask.
+    /// \details Reduced resolution levels are added until a level fits in a single tile.
     /// \param tileSize Size of tile in the tiff image
-    template <class T>
-    void createLabeledMaskStreaming(const std::string &pathLabeledMask, const uint32_t tileSize = 1024, ImageDepth depth = ImageDepth::_8U) {
-
-      uint32_t resolution = 0;
+    /// \param nbPyramidLevels Number of reduced resolution levels requested
+    /// \return Layout of the levels, full resolution first
+    std::vector<MaskLevel> maskLevels(uint32_t tileSize, uint32_t nbPyramidLevels) const {
+      std::vector<MaskLevel> levels;
+      uint64_t firstIndex = 0;
+      for (uint32_t level = 0; level <= nbPyramidLevels; ++level) {
+        MaskLevel maskLevel;
+        maskLevel.width = MaskTileRasterizer<uint8_t>::sampledRange(0, _imageWidth, level).second;
+        maskLevel.height = MaskTileRasterizer<uint8_t>::sampledRange(0, _imageHeight, level).second;
+        maskLevel.nbTileRows = (maskLevel.height + tileSize - 1) / tileSize;
+        maskLevel.nbTileCols = (maskLevel.width + tileSize - 1) / tileSize;
+        maskLevel.firstIndex = firstIndex;
+        firstIndex += (uint64_t) maskLevel.nbTileRows * maskLevel.nbTileCols;
+        levels.push_back(maskLevel);
+        if (maskLevel.nbTileRows == 1 && maskLevel.nbTileCols == 1) {
+          break;
+        }
+      }
+      return levels;
+    }
 
-      switch (depth){
-          case ImageDepth::_8U : {
-            resolution = 8 * sizeof(uint8_t);
-            break;
-          }
-          case ImageDepth::_16U : {
-            resolution = 8 * sizeof(uint16_t);
+    /// \brief List the features sampled by each tile of each level.
+    /// \param tileSize Size of tile in the tiff image
+    /// \param levels Layout of the resolution levels
+    /// \return Features intersecting each tile, by tile index
+    std::shared_ptr<std::vector<std::vector<const Feature *>>>
+    indexFeaturesByTile(uint32_t tileSize, const std::vector<MaskLevel> &levels) const {
+      auto &lastLevel = levels.back();
+      auto tileFeatures = std::make_shared<std::vector<std::vector<const Feature *>>>(
+              lastLevel.firstIndex + (uint64_t) lastLevel.nbTileRows * lastLevel.nbTileCols);
+      for (const auto &feature : _vectorFeatures) {
+        const auto &bb = feature.getBoundingBox();
+        for (uint32_t level = 0; level < levels.size(); ++level) {
+          auto rows = MaskTileRasterizer<uint8_t>::sampledRange(bb.getUpperLeftRow(), bb.getBottomRightRow(), level),
+              cols = MaskTileRasterizer<uint8_t>::sampledRange(bb.getUpperLeftCol(), bb.getBottomRightCol(), level);
+          //features smaller than the sampling step may be missed by a level
+          if (rows.first >= rows.second || cols.first >= cols.second) {
             break;
           }
-          case ImageDepth::_32U : {
-            resolution = 8 * sizeof(uint32_t);
-            break;
+          auto rowEnd = std::min((rows.second - 1) / tileSize + 1, levels[level].nbTileRows),
+              colEnd = std::min((cols.second - 1) / tileSize + 1, levels[level].nbTileCols);
+          for (auto row = rows.first / tileSize; row < rowEnd; ++row) {
+            for (auto col = cols.first / tileSize; col < colEnd; ++col) {
+              (*tileFeatures)[levels[level].firstIndex + (uint64_t) row * levels[level].nbTileCols + col]
+                  .push_back(&feature);
+            }
           }
+        }
       }
+      return tileFeatures;
+    }
 
+    /// \brief Create a tiled tiff mask, rasterizing and compressing the tiles on a pool of threads.
+    /// \details The tile buffers come from a memory pool, so only a few tiles are held in memory at any time.
+    /// The reduced resolution levels are rasterized from the features as well, and written as sub-IFDs once the full
+    /// resolution image is written.
+    /// \param pathLabeledMask Path to save the mask.
+    /// \param tileSize Size of tile in the tiff image
+    /// \param bitsPerSample Number of bits per pixel in the tiff image
+    /// \param labeled True to write the feature id + 1, false to write 255
+    /// \param nbThreads Number of threads rasterizing and compressing tiles
+    /// \param compression Tile compression
+    /// \param nbPyramidLevels Number of reduced resolution levels written as sub-IFDs
+    template <class T>
+    void writeMaskStreaming(const std::string &pathLabeledMask, uint32_t tileSize, uint16_t bitsPerSample,
+                            bool labeled, uint32_t nbThreads, MaskCompression compression,
+                            uint32_t nbPyramidLevels) {
       if ((tileSize & (tileSize - 1)) != 0) {
         std::stringstream message;
         message
@@ -713,10 +560,6 @@ class FeatureCollection {
         std::string m = message.str();
         throw (fi::FastImageException(m));
       }
-      // Get image size
-      auto
-              imageWidth = this->getImageWidth(),
-              imageHeight = this->getImageHeight();
 
       VLOG(4) << "writing bitmask";
 
@@ -725,48 +568,46 @@ class FeatureCollection {
               *tif = TIFFOpen(pathLabeledMask.c_str(), "w");
 
       if (tif != nullptr) {
-        TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, imageWidth);
-        TIFFSetField(tif, TIFFTAG_IMAGELENGTH, imageHeight);
-        TIFFSetField(tif, TIFFTAG_TILELENGTH, tileSize);
-        TIFFSetField(tif, TIFFTAG_TILEWIDTH, tileSize);
-        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, resolution);
-        TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, 1);
-        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
-        TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
-        TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
-        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-        TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-
-        auto maxTileCol = (uint32_t)std::ceil((double)this->_imageWidth / tileSize);
-        auto maxTileRow = (uint32_t)std::ceil((double)this->_imageWidth / tileSize);
-
-        for(uint32_t tileRow = 0 ; tileRow < maxTileRow ; tileRow++){
-          for(uint32_t tileCol = 0; tileCol < maxTileCol; tileCol++){
-
-            auto tile = std::vector<T>(tileSize * tileSize, 0);
-
-            for(uint32_t j = 0; j < tileSize; j++){
-              for(uint32_t i = 0; i < tileSize; i++){
-                auto f = getFeatureFromPixel(tileRow * tileSize + j, tileCol * tileSize + i);
-                if(f != nullptr) {
-                  tile[j* tileSize + i] = f->getId() + 1;
-                }
-              }
+        auto levels = maskLevels(tileSize, nbPyramidLevels);
+        TiffTileEncoder::setTags(tif, this->getImageWidth(), this->getImageHeight(), tileSize, bitsPerSample,
+                                 compression);
+        //the directories written after the full resolution one become its sub-IFDs
+        std::vector<uint64_t> subIFDOffsets(levels.size() - 1, 0);
+        if (!subIFDOffsets.empty()) {
+          TIFFSetField(tif, TIFFTAG_SUBIFD, (uint16_t) subIFDOffsets.size(), subIFDOffsets.data());
+        }
+        nbThreads = std::max(nbThreads, (uint32_t) 1);
+
+        auto graph = new htgs::TaskGraphConf<MaskTile<T>, htgs::VoidData>();
+        auto scheduler = new MaskTileScheduler<T>();
+        auto rasterizer = new MaskTileRasterizer<T>(nbThreads, tileSize, indexFeaturesByTile(tileSize, levels),
+                                                    labeled);
+        auto encoder = new MaskTileEncoder<T>(nbThreads, tileSize, bitsPerSample, compression);
+        auto writer = new OrderedMaskWriter<T>(tif, tileSize, bitsPerSample, compression, levels);
+        graph->setGraphConsumerTask(scheduler);
+        graph->addEdge(scheduler, rasterizer);
+        graph->addEdge(rasterizer, encoder);
+        graph->addEdge(encoder, writer);
+        //a couple of buffers per thread, so the rasterizers keep busy while the encoders compress
+        graph->addMemoryManagerEdge("maskTile", scheduler, new TileAllocator<T>(tileSize, tileSize),
+                                    2 * nbThreads, htgs::MMType::Static);
+
+        auto runtime = new htgs::TaskGraphRuntime(graph);
+        runtime->executeRuntime();
+
+        for (uint32_t level = 0; level < levels.size(); ++level) {
+          uint64_t index = levels[level].firstIndex;
+          for (uint32_t tileRow = 0; tileRow < levels[level].nbTileRows; tileRow++) {
+            for (uint32_t tileCol = 0; tileCol < levels[level].nbTileCols; tileCol++) {
+              graph->produceData(new MaskTile<T>(index++, level, tileRow, tileCol));
             }
-
-            TIFFWriteTile(tif,
-                          (tdata_t)tile.data(),
-                          tileCol * tileSize,
-                          tileRow * tileSize,
-                          0,
-                          0);
-
-            VLOG(4) << "done writing tile (" << tileRow << "," << tileCol << ")";
-
           }
         }
 
+        graph->finishedProducingData();
+        runtime->waitForRuntime();
+        delete runtime;
+
         TIFFClose(tif);
         VLOG(4) << "done writing mask : " << pathLabeledMask.c_str();
       } else {
@@ -776,7 +617,6 @@ class FeatureCollection {
       }
     }
 
-
  public:
 
     void createFCFromCompactListBlobs(const ListBlobs *listBlobs,
@@ -0,0 +1,105 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_FEATUREERODER_H
+#define NEWEGT_FEATUREERODER_H
+
+#include <htgs/api/ITask.hpp>
+#include <htgs/api/VoidData.hpp>
+#include <egt/api/SegmentationOptions.h>
+#include <egt/FeatureCollection/Data/BlobBatch.h>
+#include <egt/FeatureCollection/algorithms/bitmaskAlgorithms.h>
+
+namespace egt {
+
+    /**
+     * Erode the features of a batch of blobs with a 3x3 kernel. Each blob feature is replaced in place.
+     * The erosion works directly on the feature packed bitmask.
+     *
+     * Features are independent, so several instances of this task erode batches in parallel. A large feature is
+     * eroded by bands of rows in parallel, then completed once all its bands are eroded.
+     * Features whose erosion is smaller than the minimum object size are left untouched.
+     */
+    class FeatureEroder : public htgs::ITask<BlobBatch, htgs::VoidData> {
+
+    public:
+
+        /// \brief FeatureEroder constructor
+        /// \param numThreads Number of threads eroding features
+        /// \param segmentationOptions Segmentation options, giving the minimum object size
+        FeatureEroder(size_t numThreads, SegmentationOptions *segmentationOptions) :
+                ITask(numThreads), _segmentationOptions(segmentationOptions) {}
+
+        void executeTask(std::shared_ptr<BlobBatch> data) override {
+            if (data->getErosion() != nullptr) {
+                auto erosion = data->getErosion();
+                auto bb = erosion->blob->getFeature()->getBoundingBox();
+                erosion->count += BitmaskAlgorithms::erode(erosion->blob->getFeature()->getBitMask(),
+                                                           erosion->bitMask, bb.getWidth(), bb.getHeight(),
+                                                           data->getRowBegin(), data->getRowEnd());
+                return;
+            }
+            for (auto blob : data->getBlobs()) {
+                erode(blob);
+            }
+        }
+
+        std::string getName() override { return "Feature Eroder"; }
+
+        FeatureEroder *copy() override {
+            return new FeatureEroder(this->getNumThreads(), _segmentationOptions);
+        }
+
+        /// \brief Replace the feature of a blob by its eroded bitmask, covering the same bounding box.
+        /// \param blob Blob to update
+        /// \param bitMask Eroded bitmask, now owned by the blob
+        /// \param count Number of pixels in the eroded bitmask
+        static void replaceFeature(Blob *blob, uint32_t *bitMask, uint64_t count) {
+            auto feature = blob->getFeature();
+            blob->setFeature(new Feature(feature->getId(), feature->getBoundingBox(), bitMask));
+            blob->setCount(count);
+            auto bb = feature->getBoundingBox();
+            blob->setColMin(bb.getUpperLeftCol());
+            blob->setRowMin(bb.getUpperLeftRow());
+            blob->setColMax(bb.getBottomRightCol());
+            blob->setRowMax(bb.getBottomRightRow());
+            delete[] feature->getBitMask();
+            delete feature;
+        }
+
+        /// \brief Give its eroded bitmask to a blob, unless the eroded feature is smaller than the minimum object size.
+        /// \param blob Blob to update
+        /// \param bitMask Eroded bitmask, owned by the blob or deleted
+        /// \param count Number of pixels in the eroded bitmask
+        /// \param segmentationOptions Segmentation options, giving the minimum object size
+        static void completeErosion(Blob *blob, uint32_t *bitMask, uint64_t count,
+                                    SegmentationOptions *segmentationOptions) {
+            if (count < segmentationOptions->MIN_OBJECT_SIZE) {
+                delete[] bitMask;
+                VLOG(3) << "delete eroded feature. Reason : feature size < "
+                        << segmentationOptions->MIN_OBJECT_SIZE;
+                return;
+            }
+
+            replaceFeature(blob, bitMask, count);
+        }
+
+    private:
+
+        void erode(Blob *blob) {
+            auto feature = blob->getFeature();
+            auto width = feature->getBoundingBox().getWidth();
+            auto height = feature->getBoundingBox().getHeight();
+
+            auto bitMask = new uint32_t[((uint64_t) width * height + 31) / 32]();
+            auto maskCount = BitmaskAlgorithms::erode(feature->getBitMask(), bitMask, width, height, 0, height);
+            completeErosion(blob, bitMask, maskCount, _segmentationOptions);
+        }
+
+        SegmentationOptions *
+                _segmentationOptions{};     ///< Segmentation options
+    };
+}
+
+#endif //NEWEGT_FEATUREERODER_H
@@ -0,0 +1,62 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_MASKTILEENCODER_H
+#define NEWEGT_MASKTILEENCODER_H
+
+#include <htgs/api/ITask.hpp>
+#include <egt/FeatureCollection/Data/MaskTile.h>
+#include <egt/utils/TiffTileEncoder.h>
+
+namespace egt {
+
+    /**
+     * Compress the rasterized mask tiles, then give their pixels back to the memory manager.
+     *
+     * Each instance owns its encoder, so several threads compress tiles while the writer only copies bytes.
+     */
+    template<class T>
+    class MaskTileEncoder : public htgs::ITask<MaskTile<T>, MaskTile<T>> {
+
+    public:
+
+        /// \brief MaskTileEncoder constructor
+        /// \param numThreads Number of threads compressing tiles
+        /// \param tileSize Tile size
+        /// \param bitsPerSample Number of bits per pixel in the tiff image
+        /// \param compression Tile compression
+        MaskTileEncoder(size_t numThreads, uint32_t tileSize, uint16_t bitsPerSample, MaskCompression compression) :
+                htgs::ITask<MaskTile<T>, MaskTile<T>>(numThreads), _tileSize(tileSize),
+                _bitsPerSample(bitsPerSample), _compression(compression),
+                _encoder(tileSize, bitsPerSample, compression) {}
+
+        void executeTask(std::shared_ptr<MaskTile<T>> data) override {
+            data->setEncoded(_encoder.encode(data->getPixels()));
+            data->releasePixels();
+            this->addResult(data);
+        }
+
+        std::string getName() override { return "Mask Tile Encoder"; }
+
+        MaskTileEncoder *copy() override {
+            return new MaskTileEncoder(this->getNumThreads(), _tileSize, _bitsPerSample, _compression);
+        }
+
+    private:
+
+        uint32_t
+                _tileSize{};        ///< Tile size
+
+        uint16_t
+                _bitsPerSample{};   ///< Number of bits per pixel in the tiff image
+
+        MaskCompression
+                _compression{};     ///< Tile compression
+
+        TiffTileEncoder
+                _encoder;           ///< Encoder of this instance
+    };
+}
+
+#endif //NEWEGT_MASKTILEENCODER_H
@@ -0,0 +1,134 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_MASKTILERASTERIZER_H
+#define NEWEGT_MASKTILERASTERIZER_H
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <htgs/api/ITask.hpp>
+#include <egt/FeatureCollection/Data/Feature.h>
+#include <egt/FeatureCollection/Data/MaskTile.h>
+#include <egt/FeatureCollection/algorithms/bitmaskAlgorithms.h>
+
+namespace egt {
+
+    /**
+     * Rasterize the features of a mask tile.
+     *
+     * Only the features whose bounding box intersects the tile are visited, and the rows of their bitmask crossing
+     * the tile are copied into it. Reduced resolution tiles sample the features with the nearest full resolution
+     * pixel, so labels are never blended. Tiles are independent, so several instances of this task rasterize in
+     * parallel.
+     */
+    template<class T>
+    class MaskTileRasterizer : public htgs::ITask<MaskTile<T>, MaskTile<T>> {
+
+    public:
+
+        /// \brief MaskTileRasterizer constructor
+        /// \param numThreads Number of threads rasterizing tiles
+        /// \param tileSize Tile size
+        /// \param tileFeatures Features intersecting each tile, tiles being in row major order
+        /// \param labeled True to write the feature id + 1, false to write 255
+        MaskTileRasterizer(size_t numThreads, uint32_t tileSize,
+                           std::shared_ptr<const std::vector<std::vector<const Feature *>>> tileFeatures,
+                           bool labeled) :
+                htgs::ITask<MaskTile<T>, MaskTile<T>>(numThreads), _tileSize(tileSize),
+                _tileFeatures(std::move(tileFeatures)), _labeled(labeled) {}
+
+        void executeTask(std::shared_ptr<MaskTile<T>> data) override {
+            T *pixels = data->getPixels();
+            //the pixels are recycled from previous tiles
+            std::fill_n(pixels, (size_t) _tileSize * _tileSize, 0);
+
+            auto tileRowMin = data->getRow() * _tileSize,
+                    tileColMin = data->getCol() * _tileSize;
+
+            for (auto feature : (*_tileFeatures)[data->getIndex()]) {
+                auto value = _labeled ? (T) (feature->getId() + 1) : (T) 255;
+                if (data->getLevel() == 0) {
+                    copyFeature(*feature, value, tileRowMin, tileColMin, pixels);
+                } else {
+                    sampleFeature(*feature, value, data->getLevel(), tileRowMin, tileColMin, pixels);
+                }
+            }
+
+            this->addResult(data);
+        }
+
+        std::string getName() override { return "Mask Tile Rasterizer"; }
+
+        MaskTileRasterizer *copy() override {
+            return new MaskTileRasterizer(this->getNumThreads(), _tileSize, _tileFeatures, _labeled);
+        }
+
+        /// \brief Range of the rows or cols of a reduced resolution level sampling a feature.
+        /// \details The level pixel (r, c) takes the value of the full resolution pixel (r * 2^level, c * 2^level).
+        /// \param begin First full resolution row or col of the feature
+        /// \param end Full resolution row or col after the last one of the feature
+        /// \param level Resolution level
+        /// \return First level row or col, and level row or col after the last one
+        static std::pair<uint32_t, uint32_t> sampledRange(uint32_t begin, uint32_t end, uint32_t level) {
+            auto step = (uint64_t) 1 << level;
+            return {(uint32_t) ((begin + step - 1) >> level), (uint32_t) ((end + step - 1) >> level)};
+        }
+
+    private:
+
+        /// \brief Copy the bitmask rows of a feature crossing a full resolution tile.
+        void copyFeature(const Feature &feature, T value, uint32_t tileRowMin, uint32_t tileColMin, T *pixels) {
+            const auto &bb = feature.getBoundingBox();
+            auto rowBegin = std::max(bb.getUpperLeftRow(), tileRowMin),
+                    rowEnd = std::min(bb.getBottomRightRow(), tileRowMin + _tileSize),
+                    colBegin = std::max(bb.getUpperLeftCol(), tileColMin),
+                    colEnd = std::min(bb.getBottomRightCol(), tileColMin + _tileSize);
+
+            for (auto row = rowBegin; row < rowEnd; ++row) {
+                auto pos = (uint64_t) (row - bb.getUpperLeftRow()) * bb.getWidth()
+                           + (colBegin - bb.getUpperLeftCol());
+                BitmaskAlgorithms::bitRunToArray(feature.getBitMask(), pos, colEnd - colBegin,
+                                                 pixels + (size_t) (row - tileRowMin) * _tileSize
+                                                 + (colBegin - tileColMin),
+                                                 value);
+            }
+        }
+
+        /// \brief Sample a feature in a reduced resolution tile, with the nearest full resolution pixel.
+        void sampleFeature(const Feature &feature, T value, uint32_t level, uint32_t tileRowMin, uint32_t tileColMin,
+                           T *pixels) {
+            const auto &bb = feature.getBoundingBox();
+            auto rows = sampledRange(bb.getUpperLeftRow(), bb.getBottomRightRow(), level),
+                    cols = sampledRange(bb.getUpperLeftCol(), bb.getBottomRightCol(), level);
+            auto rowBegin = std::max(rows.first, tileRowMin),
+                    rowEnd = std::min(rows.second, tileRowMin + _tileSize),
+                    colBegin = std::max(cols.first, tileColMin),
+                    colEnd = std::min(cols.second, tileColMin + _tileSize);
+
+            for (auto row = rowBegin; row < rowEnd; ++row) {
+                auto rowPos = (uint64_t) ((row << level) - bb.getUpperLeftRow()) * bb.getWidth();
+                T *dst = pixels + (size_t) (row - tileRowMin) * _tileSize;
+                for (auto col = colBegin; col < colEnd; ++col) {
+                    if (BitmaskAlgorithms::isBitSet(feature.getBitMask(),
+                                                    rowPos + (col << level) - bb.getUpperLeftCol())) {
+                        dst[col - tileColMin] = value;
+                    }
+                }
+            }
+        }
+
+        uint32_t
+                _tileSize{};    ///< Tile size
+
+        std::shared_ptr<const std::vector<std::vector<const Feature *>>>
+                _tileFeatures{};    ///< Features intersecting each tile
+
+        bool
+                _labeled{};     ///< True to write the feature id + 1, false to write 255
+    };
+}
+
+#endif //NEWEGT_MASKTILERASTERIZER_H
@@ -0,0 +1,40 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_MASKTILESCHEDULER_H
+#define NEWEGT_MASKTILESCHEDULER_H
+
+#include <htgs/api/ITask.hpp>
+#include <egt/FeatureCollection/Data/MaskTile.h>
+#include <egt/memory/ReleaseMemoryRule.h>
+
+namespace egt {
+
+    /**
+     * Attach the pixels from the "maskTile" memory manager to the mask tiles, in the order they are produced.
+     *
+     * Running on a single thread, tiles get their pixels in tile order, so the pool goes to the tiles the ordered
+     * writer needs first.
+     */
+    template<class T>
+    class MaskTileScheduler : public htgs::ITask<MaskTile<T>, MaskTile<T>> {
+
+    public:
+
+        MaskTileScheduler() : htgs::ITask<MaskTile<T>, MaskTile<T>>(1) {}
+
+        void executeTask(std::shared_ptr<MaskTile<T>> data) override {
+            data->setPixels(this->template getMemory<T>("maskTile", new ReleaseMemoryRule(1)));
+            this->addResult(data);
+        }
+
+        std::string getName() override { return "Mask Tile Scheduler"; }
+
+        MaskTileScheduler *copy() override {
+            return new MaskTileScheduler();
+        }
+    };
+}
+
+#endif //NEWEGT_MASKTILESCHEDULER_H
@@ -0,0 +1,104 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_ORDEREDMASKWRITER_H
+#define NEWEGT_ORDEREDMASKWRITER_H
+
+#include <map>
+#include <vector>
+#include <htgs/api/ITask.hpp>
+#include <htgs/api/VoidData.hpp>
+#include <tiffio.h>
+#include <glog/logging.h>
+#include <egt/FeatureCollection/Data/MaskTile.h>
+#include <egt/utils/TiffTileEncoder.h>
+
+namespace egt {
+
+    /**
+     * Write the encoded mask tiles to a tiled tiff, in tile order.
+     *
+     * Tiles arriving ahead of their turn are kept until all the tiles before them are written, so the file is
+     * written sequentially. The first tile of each reduced resolution level closes the previous directory and opens
+     * the directory of its level, written as a sub-IFD of the full resolution image.
+     * This task runs on a single thread, the tiff file being opened and closed by its owner, with the full resolution
+     * directory tags already set.
+     */
+    template<class T>
+    class OrderedMaskWriter : public htgs::ITask<MaskTile<T>, htgs::VoidData> {
+
+    public:
+
+        /// \brief OrderedMaskWriter constructor
+        /// \param tif Tiff file to write to
+        /// \param tileSize Tile size
+        /// \param bitsPerSample Number of bits per pixel in the tiff image
+        /// \param compression Tile compression
+        /// \param levels Layout of the resolution levels, full resolution first
+        OrderedMaskWriter(TIFF *tif, uint32_t tileSize, uint16_t bitsPerSample, MaskCompression compression,
+                          std::vector<MaskLevel> levels) :
+                htgs::ITask<MaskTile<T>, htgs::VoidData>(1), _tif(tif), _tileSize(tileSize),
+                _bitsPerSample(bitsPerSample), _compression(compression), _levels(std::move(levels)) {}
+
+        void executeTask(std::shared_ptr<MaskTile<T>> data) override {
+            _pendingTiles.emplace(data->getIndex(), data);
+
+            for (auto tile = _pendingTiles.begin();
+                 tile != _pendingTiles.end() && tile->first == _nextIndex;
+                 tile = _pendingTiles.erase(tile), ++_nextIndex) {
+                auto maskTile = tile->second;
+                if (maskTile->getLevel() != _level) {
+                    startLevel(maskTile->getLevel());
+                }
+                auto &encoded = maskTile->getEncoded();
+                TIFFWriteRawTile(_tif, TIFFComputeTile(_tif, maskTile->getCol() * _tileSize,
+                                                       maskTile->getRow() * _tileSize, 0, 0),
+                                 (void *) encoded.data(), (tmsize_t) encoded.size());
+                VLOG(4) << "done writing tile (" << maskTile->getRow() << "," << maskTile->getCol() << ") of level "
+                        << maskTile->getLevel();
+            }
+        }
+
+        std::string getName() override { return "Ordered Mask Writer"; }
+
+        OrderedMaskWriter *copy() override {
+            return new OrderedMaskWriter(_tif, _tileSize, _bitsPerSample, _compression, _levels);
+        }
+
+    private:
+
+        /// \brief Close the current directory and open the directory of a reduced resolution level.
+        void startLevel(uint32_t level) {
+            TIFFWriteDirectory(_tif);
+            TiffTileEncoder::setTags(_tif, _levels[level].width, _levels[level].height, _tileSize, _bitsPerSample,
+                                     _compression);
+            TIFFSetField(_tif, TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+            _level = level;
+        }
+
+        TIFF
+                *_tif = nullptr;    ///< Tiff file to write to
+
+        uint32_t
+                _tileSize{},        ///< Tile size
+                _level = 0;         ///< Level of the current directory
+
+        uint16_t
+                _bitsPerSample{};   ///< Number of bits per pixel in the tiff image
+
+        MaskCompression
+                _compression{};     ///< Tile compression
+
+        std::vector<MaskLevel>
+                _levels{};          ///< Layout of the resolution levels
+
+        uint64_t
+                _nextIndex = 0;     ///< Index of the next tile to write
+
+        std::map<uint64_t, std::shared_ptr<MaskTile<T>>>
+                _pendingTiles{};    ///< Tiles waiting for their turn, by index
+    };
+}
+
+#endif //NEWEGT_ORDEREDMASKWRITER_H
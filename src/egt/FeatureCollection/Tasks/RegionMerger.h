@@ -0,0 +1,59 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_REGIONMERGER_H
+#define NEWEGT_REGIONMERGER_H
+
+#include <htgs/api/ITask.hpp>
+#include <egt/FeatureCollection/Data/MergeJob.h>
+#include <egt/FeatureCollection/Data/ViewAnalyse.h>
+#include <egt/FeatureCollection/algorithms/regionMerge.h>
+
+namespace egt {
+
+    /**
+     * Merge the analyses of up to 2x2 neighboring regions into the analyse of their parent region.
+     *
+     * Merge jobs of the same level are independent, so several instances of this task process them in parallel.
+     * The merged analyses go back to the merge bookkeeper, until the root region covering the whole image is built.
+     */
+    class RegionMerger : public htgs::ITask<MergeJob, ViewAnalyse> {
+
+    public:
+
+        /// \brief RegionMerger constructor
+        /// \param numThreads Number of threads merging regions
+        /// \param imageHeight Image height
+        /// \param imageWidth Image width
+        /// \param tileHeight Tile height
+        /// \param tileWidth Tile width
+        RegionMerger(size_t numThreads, uint32_t imageHeight, uint32_t imageWidth, uint32_t tileHeight,
+                     uint32_t tileWidth) :
+                ITask(numThreads), _imageHeight(imageHeight), _imageWidth(imageWidth), _tileHeight(tileHeight),
+                _tileWidth(tileWidth), _regionMerge(imageHeight, imageWidth, tileHeight, tileWidth) {}
+
+        void executeTask(std::shared_ptr<MergeJob> data) override {
+            this->addResult(_regionMerge.merge(*data));
+        }
+
+        std::string getName() override { return "Region Merge"; }
+
+        RegionMerger *copy() override {
+            return new RegionMerger(this->getNumThreads(), _imageHeight, _imageWidth, _tileHeight, _tileWidth);
+        }
+
+    private:
+
+        uint32_t
+                _imageHeight{},
+                _imageWidth{},
+                _tileHeight{},
+                _tileWidth{};
+
+        RegionMerge
+                _regionMerge;   ///< Merge algorithm
+    };
+}
+
+#endif //NEWEGT_REGIONMERGER_H
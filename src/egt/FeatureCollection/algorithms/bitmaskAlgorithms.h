@@ -5,8 +5,10 @@
 #ifndef NEWEGT_BITMASKALGORITHMS_H
 #define NEWEGT_BITMASKALGORITHMS_H
 
+#include <algorithm>
 #include <cstdint>
 #include <cmath>
+#include <vector>
 
 namespace egt {
 
@@ -108,8 +110,173 @@ namespace egt {
             return foregroundCount;
         }
 
+        /// Set a run of consecutive bits in the bitmask, a whole word at a time.
+        /// \param bitmask the destination bitmask
+        /// \param pos the 1D index of the first pixel of the run
+        /// \param length the number of pixels in the run
+        static void addRunToBitMask(uint32_t *bitmask, uint64_t pos, uint32_t length) {
+            while (length > 0) {
+                auto offset = (uint32_t) (pos & (uint32_t) 31);
+                auto count = std::min(length, (uint32_t) 32 - offset);
+                bitmask[pos >> (uint32_t) 5] |= leadingBits(count) >> offset;
+                pos += count;
+                length -= count;
+            }
+        }
+
+        /// OR a source bitmask into a destination bitmask, the source upper left pixel being placed
+        /// at (rowOffset, colOffset) in the destination.
+        /// Each source row is copied 32 bits at a time.
+        /// NOTE Boundary checks are not performed, the source must fit in the destination.
+        /// \param src the source bitmask
+        /// \param srcWidth the width of the source bitmask
+        /// \param srcHeight the height of the source bitmask
+        /// \param dst the destination bitmask
+        /// \param dstWidth the width of the destination bitmask
+        /// \param rowOffset the destination row of the source first row
+        /// \param colOffset the destination col of the source first col
+        static void orBitMask(const uint32_t *src, uint32_t srcWidth, uint32_t srcHeight,
+                              uint32_t *dst, uint32_t dstWidth, uint32_t rowOffset, uint32_t colOffset) {
+            for (uint32_t row = 0; row < srcHeight; ++row) {
+                auto srcPos = (uint64_t) row * srcWidth;
+                auto dstPos = (uint64_t) (row + rowOffset) * dstWidth + colOffset;
+                for (uint32_t col = 0; col < srcWidth; col += 32) {
+                    auto count = std::min((uint32_t) 32, srcWidth - col);
+                    auto bits = readBits(src, srcPos + col, count);
+                    if (bits != 0) {
+                        writeBits(dst, dstPos + col, count, bits);
+                    }
+                }
+            }
+        }
+
+        /// Erode a bitmask with a 3x3 square kernel, working on whole words.
+        /// Pixels outside the bitmask are considered foreground, as OpenCV does by default.
+        /// Only the rows in [rowBegin, rowEnd) are written, so a bitmask can be eroded by bands of rows.
+        /// NOTE rows of a band may share their first and last word with the neighbor bands. Bands of the same
+        /// destination can only be eroded concurrently if they begin on multiples of 32 rows, so they share no word.
+        /// \param src the source bitmask
+        /// \param dst the destination bitmask, of the same size, with the band rows cleared
+        /// \param width the width of the bitmask
+        /// \param height the height of the bitmask
+        /// \param rowBegin the first row to erode
+        /// \param rowEnd the row after the last row to erode
+        /// \return the number of foreground pixels in the eroded rows
+        static uint64_t erode(const uint32_t *src, uint32_t *dst, uint32_t width, uint32_t height,
+                              uint32_t rowBegin, uint32_t rowEnd) {
+            if (width == 0 || rowBegin >= rowEnd) {
+                return 0;
+            }
+
+            auto nbWords = (width + (uint32_t) 31) >> (uint32_t) 5;
+            //the last word of a row is padded with foreground pixels
+            auto padding = ~leadingBits(width - ((nbWords - 1) << (uint32_t) 5));
+
+            //horizontally eroded rows above, at and below the current row, all foreground outside the bitmask
+            std::vector<uint32_t> rows(3 * nbWords, ~(uint32_t) 0), row(nbWords);
+            auto above = rows.data(), center = above + nbWords, below = center + nbWords;
+
+            auto erodeRow = [&](uint32_t r, uint32_t *out) {
+                if (r >= height) {
+                    std::fill(out, out + nbWords, ~(uint32_t) 0);
+                    return;
+                }
+                auto pos = (uint64_t) r * width;
+                for (uint32_t word = 0; word < nbWords; ++word) {
+                    auto count = std::min((uint32_t) 32, width - (word << (uint32_t) 5));
+                    row[word] = readBits(src, pos + (word << (uint32_t) 5), count);
+                }
+                row[nbWords - 1] |= padding;
+                for (uint32_t word = 0; word < nbWords; ++word) {
+                    auto left = (row[word] >> (uint32_t) 1) |
+                                ((word == 0 ? (uint32_t) 1 : row[word - 1]) << (uint32_t) 31);
+                    auto right = (row[word] << (uint32_t) 1) |
+                                 (word + 1 == nbWords ? (uint32_t) 1 : row[word + 1] >> (uint32_t) 31);
+                    out[word] = row[word] & left & right;
+                }
+            };
+
+            if (rowBegin > 0) {
+                erodeRow(rowBegin - 1, above);
+            }
+            erodeRow(rowBegin, center);
+
+            uint64_t count = 0;
+            for (auto r = rowBegin; r < rowEnd; ++r) {
+                erodeRow(r + 1, below);
+                auto pos = (uint64_t) r * width;
+                for (uint32_t word = 0; word < nbWords; ++word) {
+                    auto bits = above[word] & center[word] & below[word];
+                    auto nbBits = std::min((uint32_t) 32, width - (word << (uint32_t) 5));
+                    bits &= leadingBits(nbBits);
+                    if (bits != 0) {
+                        count += (uint64_t) __builtin_popcount(bits);
+                        writeBits(dst, pos + (word << (uint32_t) 5), nbBits, bits);
+                    }
+                }
+                std::swap(above, center);
+                std::swap(center, below);
+            }
+            return count;
+        }
+
+        /// Write a value in an array for each set bit of a run of consecutive bits.
+        /// The bits are read 32 at a time, empty words are skipped and full words are filled at once.
+        /// \tparam T the destination array resolution
+        /// \param bitmask the bitmask to read
+        /// \param pos the bit position of the run beginning
+        /// \param length the number of bits in the run
+        /// \param dst the destination array, dst[0] receiving the bit at `pos`
+        /// \param value the value written for set bits, the other entries being left untouched
+        template<class T>
+        static void bitRunToArray(const uint32_t *bitmask, uint64_t pos, uint32_t length, T *dst, T value) {
+            while (length > 0) {
+                auto count = std::min(length, (uint32_t) 32);
+                auto bits = readBits(bitmask, pos, count);
+                if (bits == leadingBits(count)) {
+                    std::fill_n(dst, count, value);
+                } else {
+                    for (uint32_t k = 0; bits != 0; ++k, bits <<= (uint32_t) 1) {
+                        if (bits & 0x80000000u) {
+                            dst[k] = value;
+                        }
+                    }
+                }
+                pos += count;
+                dst += count;
+                length -= count;
+            }
+        }
 
     private:
+        /// \return a word with its `count` most significant bits set, count being in [1, 32]
+        static uint32_t leadingBits(uint32_t count) {
+            return (uint32_t) (~(uint64_t) 0 << ((uint32_t) 64 - count) >> (uint32_t) 32);
+        }
+
+        /// Read `count` consecutive bits, count being in [1, 32].
+        /// \return the bits, aligned on the most significant bit of the word
+        static uint32_t readBits(const uint32_t *bitmask, uint64_t pos, uint32_t count) {
+            auto word = pos >> (uint32_t) 5;
+            auto offset = (uint32_t) (pos & (uint32_t) 31);
+            uint64_t bits = (uint64_t) bitmask[word] << (uint32_t) 32;
+            //only read the next word if the bits span over it, it may be past the end of the bitmask
+            if (offset + count > 32) {
+                bits |= bitmask[word + 1];
+            }
+            return (uint32_t) (bits << offset >> (uint32_t) 32) & leadingBits(count);
+        }
+
+        /// OR `count` bits aligned on the most significant bit of `bits` at a bit position, count being in [1, 32].
+        static void writeBits(uint32_t *bitmask, uint64_t pos, uint32_t count, uint32_t bits) {
+            auto word = pos >> (uint32_t) 5;
+            auto offset = (uint32_t) (pos & (uint32_t) 31);
+            bitmask[word] |= bits >> offset;
+            if (offset + count > 32) {
+                bitmask[word + 1] |= bits << ((uint32_t) 32 - offset);
+            }
+        }
+
         static void addPixelToBitMask(uint32_t *bitmask, uint64_t pos) {
             // Add it to the bit mask
             //optimization : right-shifting binary representation by 5 is equivalent to dividing by 32
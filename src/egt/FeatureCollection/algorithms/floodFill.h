@@ -0,0 +1,102 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_FLOODFILL_H
+#define NEWEGT_FLOODFILL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace egt {
+
+    /**
+     * Flood fill connected component labeling (https://en.wikipedia.org/wiki/Flood_fill).
+     *
+     * Pixels are scanned in raster order and each pixel not visited yet starts a new component, flooded before the scan
+     * goes on. The frontier is a stack of packed row * width + col indices. Pixels are marked as visited when pushed,
+     * so each pixel is pushed once and the stack never grows past the region size.
+     *
+     * The stack is kept between calls so a task instance can reuse it for every tile it processes.
+     */
+    class FloodFill {
+
+    public :
+
+        /// Reserve the stack for regions of up to nbPixels pixels.
+        void reserve(size_t nbPixels) {
+            _toVisit.reserve(nbPixels);
+        }
+
+        /// Flood all the components of a height x width region.
+        /// \tparam Predicate callable (int32_t row, int32_t col) -> bool telling if the pixel belongs to the color we
+        /// label and is not visited yet.
+        /// \tparam Mark callable (int32_t row, int32_t col) marking the pixel as visited.
+        /// \tparam Start callable (int32_t row, int32_t col) called with the first pixel of each component.
+        /// \tparam Add callable (int32_t row, int32_t col) called once for each pixel of the component, first one included.
+        /// \tparam End callable () called once all the pixels of the component have been added.
+        /// \param eightConnectivity if true diagonal neighbors are connected, otherwise only N, S, E, W neighbors are.
+        template<class Predicate, class Mark, class Start, class Add, class End>
+        void fill(int32_t height, int32_t width, bool eightConnectivity, Predicate isCandidate, Mark markAsVisited,
+                  Start startComponent, Add addPixel, End endComponent) {
+            _toVisit.clear();
+
+            auto push = [&](int32_t row, int32_t col) {
+                markAsVisited(row, col);
+                _toVisit.push_back((uint32_t) (row * width + col));
+            };
+
+            for (int32_t row = 0; row < height; ++row) {
+                for (int32_t col = 0; col < width; ++col) {
+                    if (!isCandidate(row, col)) {
+                        continue;
+                    }
+
+                    startComponent(row, col);
+                    push(row, col);
+
+                    while (!_toVisit.empty()) {
+                        auto index = _toVisit.back();
+                        _toVisit.pop_back();
+                        int32_t pRow = index / width, pCol = index % width;
+
+                        addPixel(pRow, pCol);
+
+                        if (eightConnectivity) {
+                            for (int32_t rowN = (pRow > 0 ? pRow - 1 : 0); rowN < height && rowN <= pRow + 1; ++rowN) {
+                                for (int32_t colN = (pCol > 0 ? pCol - 1 : 0); colN < width && colN <= pCol + 1; ++colN) {
+                                    //the pixel itself is visited already
+                                    if (isCandidate(rowN, colN)) {
+                                        push(rowN, colN);
+                                    }
+                                }
+                            }
+                        } else {
+                            if (pRow >= 1 && isCandidate(pRow - 1, pCol)) {
+                                push(pRow - 1, pCol);
+                            }
+                            if (pRow + 1 < height && isCandidate(pRow + 1, pCol)) {
+                                push(pRow + 1, pCol);
+                            }
+                            if (pCol >= 1 && isCandidate(pRow, pCol - 1)) {
+                                push(pRow, pCol - 1);
+                            }
+                            if (pCol + 1 < width && isCandidate(pRow, pCol + 1)) {
+                                push(pRow, pCol + 1);
+                            }
+                        }
+                    }
+
+                    endComponent();
+                }
+            }
+        }
+
+    private:
+
+        std::vector<uint32_t> _toVisit{}; ///< pixels (row * width + col) waiting to be explored.
+    };
+}
+
+#endif //NEWEGT_FLOODFILL_H
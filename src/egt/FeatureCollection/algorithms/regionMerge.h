@@ -0,0 +1,291 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_REGIONMERGE_H
+#define NEWEGT_REGIONMERGE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <list>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <FastImage/FeatureCollection/tools/UnionFind.h>
+#include <egt/FeatureCollection/Data/Blob.h>
+#include <egt/FeatureCollection/Data/BlobIndex.h>
+#include <egt/FeatureCollection/Data/MergeJob.h>
+#include <egt/FeatureCollection/Data/ViewAnalyse.h>
+
+namespace egt {
+
+    /**
+     * Merge the analyses of neighboring regions of the image into the analyse of their parent region.
+     *
+     * Regions form a quadtree over the grid of tiles : a region of level n covers 2^n x 2^n tiles and is merged
+     * from the (up to) 2x2 regions of level n - 1 it covers. Tiles are the regions of level 0.
+     *
+     * The blobs of a merged region are united with a union find, using the merge coordinates that fall inside
+     * the region. Blobs touching a region side shared with another region stay open : they keep the merge
+     * coordinates pointing outside the region and are merged at the next level. The other blobs are completed.
+     * At the root level, the region covers the whole image and all blobs are completed.
+     *
+     * Only the open blobs move up the tree. Completed blobs stay in the analyse of the region that completed them,
+     * tiles included, which sends them to the BlobMerger to be filtered and released.
+     */
+    class RegionMerge {
+
+    public:
+
+        /// \brief RegionMerge constructor
+        /// \param imageHeight Image height
+        /// \param imageWidth Image width
+        /// \param tileHeight Tile height
+        /// \param tileWidth Tile width
+        RegionMerge(uint32_t imageHeight, uint32_t imageWidth, uint32_t tileHeight, uint32_t tileWidth) :
+                _imageHeight(imageHeight), _imageWidth(imageWidth), _tileHeight(tileHeight), _tileWidth(tileWidth) {
+            _nbTilesHeight = (imageHeight + tileHeight - 1) / tileHeight;
+            _nbTilesWidth = (imageWidth + tileWidth - 1) / tileWidth;
+        }
+
+        /// \brief Number of regions along one dimension at a merge level.
+        /// \param nbTiles Number of tiles along this dimension
+        /// \param level Merge level
+        /// \return Number of regions
+        static uint32_t nbRegions(uint32_t nbTiles, uint32_t level) {
+            return (uint32_t) (((uint64_t) nbTiles + ((uint64_t) 1 << level) - 1) >> level);
+        }
+
+        /// \return First level with a single region covering the whole image
+        uint32_t getRootLevel() const {
+            uint32_t level = 0;
+            while (nbRegions(_nbTilesHeight, level) > 1 || nbRegions(_nbTilesWidth, level) > 1) {
+                level++;
+            }
+            return level;
+        }
+
+        /// \brief Number of regions a parent region is merged from.
+        /// \param level Level of the parent region, at least 1
+        /// \param row Row of the parent region
+        /// \param col Col of the parent region
+        /// \return Number of children, from 1 to 4
+        uint32_t getNbChildren(uint32_t level, uint32_t row, uint32_t col) const {
+            auto nbRows = std::min(2u, nbRegions(_nbTilesHeight, level - 1) - 2 * row),
+                    nbCols = std::min(2u, nbRegions(_nbTilesWidth, level - 1) - 2 * col);
+            return nbRows * nbCols;
+        }
+
+        /// \brief Merge the analyses of a merge job into the analyse of the parent region.
+        /// \details Open blobs of the children are moved into the parent analyse, blobs merged into another one
+        /// are deleted. The completed blobs of the children are left to the BlobMerger.
+        /// \param job Merge job
+        /// \return Analyse of the parent region
+        std::shared_ptr<ViewAnalyse> merge(const MergeJob &job) {
+            auto parent = std::make_shared<ViewAnalyse>(job.getRow(), job.getCol(), job.getLevel());
+
+            Region region{};
+            region.rowStart = std::min(_imageHeight, (job.getRow() << job.getLevel()) * _tileHeight);
+            region.rowEnd = std::min(_imageHeight, ((job.getRow() + 1) << job.getLevel()) * _tileHeight);
+            region.colStart = std::min(_imageWidth, (job.getCol() << job.getLevel()) * _tileWidth);
+            region.colEnd = std::min(_imageWidth, ((job.getCol() + 1) << job.getLevel()) * _tileWidth);
+
+            std::vector<Blob *> openHoles, openObjects;
+            std::unordered_map<Blob *, std::list<Coordinate>> holesToMerge, objectsToMerge;
+
+            for (const auto &child : job.getChildren()) {
+                collect(child->getHoles(), child->getHolesToMerge(), openHoles, holesToMerge);
+                collect(child->getBlobs(), child->getToMerge(), openObjects, objectsToMerge);
+            }
+
+            mergeRegion(region, openHoles, holesToMerge, parent->getCompletedHoles(),
+                        [&parent](Blob *hole) { parent->insertHole(hole); },
+                        [&parent](Blob *hole, const Coordinate &coord) { parent->addHolesToMerge(hole, coord); });
+            mergeRegion(region, openObjects, objectsToMerge, parent->getCompletedBlobs(),
+                        [&parent](Blob *blob) { parent->insertBlob(blob); },
+                        [&parent](Blob *blob, const Coordinate &coord) { parent->addToMerge(blob, coord); });
+
+            VLOG(4) << "region (" << job.getRow() << "," << job.getCol() << ") of level " << job.getLevel()
+                    << " merged. " << parent->getBlobs().size() << " objects and " << parent->getHoles().size()
+                    << " holes left open.";
+
+            return parent;
+        }
+
+        /// \brief Merge several blobs into the parent. The other blobs are deleted.
+        /// \details The resulting feature bitmask covers the tightest bounding box containing all the blobs.
+        /// \tparam Container Blob container
+        /// \param parent Blob that will contain the merged feature
+        /// \param sons Blobs to merge, may contain the parent
+        template<class Container>
+        static void mergeIntoParent(Blob *parent, const Container &sons) {
+            auto bb = calculateBoundingBox(sons);
+            double size = ceil((bb.getHeight() * bb.getWidth()) / 32.);
+            auto *bitMask = new uint32_t[(uint32_t) size]();
+
+            //the parent will contain the merged feature
+            parent->addToBitMask(bitMask, bb);
+
+            for (auto son : sons) {
+                if (son == parent) {
+                    continue;
+                }
+                son->addToBitMask(bitMask, bb);
+                parent->setCount(parent->getCount() + son->getCount());
+                parent->setIntensitySum(parent->getIntensitySum() + son->getIntensitySum());
+                delete son; //we keep only the parent, we can delete the sons
+            }
+
+            delete[] parent->getFeature()->getBitMask();
+            delete parent->getFeature();
+            auto *feature = new Feature(parent->getTag(), bb, bitMask);
+
+            //For consistency, let's update redundant info
+            parent->setRowMin(bb.getUpperLeftRow());
+            parent->setRowMax(bb.getBottomRightRow());
+            parent->setColMin(bb.getUpperLeftCol());
+            parent->setColMax(bb.getBottomRightCol());
+
+            parent->setFeature(feature);
+        }
+
+        /**
+         * Calculate the tightest bounding box containing all the blobs individual bounding box.
+         * @param sons
+         * @return
+         */
+        template<class Container>
+        static BoundingBox calculateBoundingBox(const Container &sons) {
+
+            uint32_t upperLeftRow = std::numeric_limits<int32_t>::max(),
+                    upperLeftCol = std::numeric_limits<int32_t>::max(),
+                    bottomRightRow = 0,
+                    bottomRightCol = 0;
+
+            for (auto son : sons) {
+                auto bb = son->getFeature()->getBoundingBox();
+                upperLeftRow = (bb.getUpperLeftRow() < upperLeftRow) ? bb.getUpperLeftRow() : upperLeftRow;
+                upperLeftCol = (bb.getUpperLeftCol() < upperLeftCol) ? bb.getUpperLeftCol() : upperLeftCol;
+                bottomRightRow = (bb.getBottomRightRow() > bottomRightRow) ? bb.getBottomRightRow() : bottomRightRow;
+                bottomRightCol = bb.getBottomRightCol() > bottomRightCol ? bb.getBottomRightCol() : bottomRightCol;
+            }
+
+            return BoundingBox(upperLeftRow, upperLeftCol, bottomRightRow, bottomRightCol);
+        }
+
+    private:
+
+        /// Pixel extent of a region, ends excluded
+        struct Region {
+            uint32_t rowStart, rowEnd, colStart, colEnd;
+        };
+
+        /// Gather the open blobs of a child analyse and their merge coordinates.
+        static void collect(const std::list<Blob *> &blobs,
+                            const std::unordered_map<Blob *, std::list<Coordinate>> &toMerge,
+                            std::vector<Blob *> &open, std::unordered_map<Blob *, std::list<Coordinate>> &coords) {
+            open.insert(open.end(), blobs.begin(), blobs.end());
+            for (const auto &blobCoords : toMerge) {
+                auto &blobCoordsCopy = coords[blobCoords.first];
+                blobCoordsCopy.insert(blobCoordsCopy.end(), blobCoords.second.begin(), blobCoords.second.end());
+            }
+        }
+
+        /// Unite the open blobs of a region, merge each group into a single blob and sort the result
+        /// between the blobs still open and the completed ones.
+        template<class Insert, class AddToMerge>
+        void mergeRegion(const Region &region, const std::vector<Blob *> &open,
+                         std::unordered_map<Blob *, std::list<Coordinate>> &toMerge, std::list<Blob *> &completed,
+                         Insert insert, AddToMerge addToMerge) {
+            if (open.empty()) {
+                return;
+            }
+
+            fc::UnionFind<Blob> uf{};
+            std::unordered_map<Blob *, std::list<Coordinate>> outgoing{};
+
+            {
+                BlobIndex index(region.rowStart, region.colStart, region.rowEnd - region.rowStart,
+                                region.colEnd - region.colStart, _tileHeight, _tileWidth, open);
+                for (auto &blobCoords : toMerge) {
+                    for (const auto &coord : blobCoords.second) {
+                        if (coord.first < 0 || coord.second < 0 || (uint32_t) coord.first >= _imageHeight ||
+                            (uint32_t) coord.second >= _imageWidth) {
+                            continue;
+                        }
+                        if (isInRegion(region, coord)) {
+                            if (auto other = index.find(coord.first, coord.second)) {
+                                uf.unionElements(blobCoords.first, other);
+                            }
+                        } else {
+                            outgoing[blobCoords.first].push_back(coord);
+                        }
+                    }
+                }
+            }
+
+            // roots must all be known before the groups are merged, merging deletes the sons
+            std::unordered_map<Blob *, std::vector<Blob *>> groups{};
+            for (auto blob : open) {
+                groups[uf.find(blob)].push_back(blob);
+            }
+
+            std::unordered_map<Blob *, Blob *> roots{};
+            for (const auto &blobCoords : outgoing) {
+                roots[blobCoords.first] = uf.find(blobCoords.first);
+            }
+
+            for (auto &group : groups) {
+                if (group.second.size() > 1) {
+                    mergeIntoParent(group.first, group.second);
+                }
+            }
+
+            std::unordered_map<Blob *, std::list<Coordinate>> rootsOutgoing{};
+            for (auto &blobCoords : outgoing) {
+                auto &rootCoords = rootsOutgoing[roots.at(blobCoords.first)];
+                rootCoords.splice(rootCoords.end(), blobCoords.second);
+            }
+
+            for (const auto &group : groups) {
+                auto root = group.first;
+                if (touchesInnerSide(region, root)) {
+                    insert(root);
+                    auto coords = rootsOutgoing.find(root);
+                    if (coords != rootsOutgoing.end()) {
+                        for (const auto &coord : coords->second) {
+                            addToMerge(root, coord);
+                        }
+                    }
+                } else {
+                    completed.push_back(root);
+                }
+            }
+        }
+
+        static bool isInRegion(const Region &region, const Coordinate &coord) {
+            return (uint32_t) coord.first >= region.rowStart && (uint32_t) coord.first < region.rowEnd &&
+                   (uint32_t) coord.second >= region.colStart && (uint32_t) coord.second < region.colEnd;
+        }
+
+        /// A blob can be connected to another region only if it touches a region side that is not an image side.
+        bool touchesInnerSide(const Region &region, const Blob *blob) const {
+            return (region.rowStart != 0 && (uint32_t) blob->getRowMin() == region.rowStart) ||
+                   (region.rowEnd != _imageHeight && (uint32_t) blob->getRowMax() == region.rowEnd) ||
+                   (region.colStart != 0 && (uint32_t) blob->getColMin() == region.colStart) ||
+                   (region.colEnd != _imageWidth && (uint32_t) blob->getColMax() == region.colEnd);
+        }
+
+        uint32_t
+                _imageHeight{},
+                _imageWidth{},
+                _tileHeight{},
+                _tileWidth{},
+                _nbTilesHeight{},
+                _nbTilesWidth{};
+    };
+}
+
+#endif //NEWEGT_REGIONMERGE_H
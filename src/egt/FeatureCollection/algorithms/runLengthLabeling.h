@@ -0,0 +1,134 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_RUNLENGTHLABELING_H
+#define NEWEGT_RUNLENGTHLABELING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace egt {
+
+    /// A horizontal sequence of pixels of the same color, in tile coordinates.
+    /// colEnd is exclusive.
+    struct LabeledRun {
+        int32_t row;
+        int32_t colStart;
+        int32_t colEnd;
+        uint32_t label;
+    };
+
+    /**
+     * Run-based connected component labeling.
+     *
+     * Each row is scanned into runs. Runs of consecutive rows that touch are united with a union-find,
+     * then labels are flattened to consecutive component ids, in raster order of the component first pixel.
+     * The union always keeps the smallest label as the root, so the root of a component is its first run.
+     *
+     * Buffers are kept between calls so a task instance can reuse them for every tile it processes.
+     */
+    class RunLengthLabeling {
+
+    public :
+
+        /// Label a height x width region.
+        /// \tparam Predicate callable (int32_t row, int32_t col) -> bool telling if the pixel belongs to the color we label.
+        /// \param eightConnectivity if true diagonal neighbors are connected, otherwise only N, S, E, W neighbors are.
+        /// \return the number of components found. Runs are labeled with their component id.
+        template<class Predicate>
+        uint32_t label(int32_t height, int32_t width, bool eightConnectivity, Predicate isSet) {
+            _runs.clear();
+            _parents.clear();
+
+            //with 8-connectivity, runs touching only by a corner are also connected.
+            const int32_t slack = eightConnectivity ? 1 : 0;
+            size_t previousRowBegin = 0, previousRowEnd = 0;
+
+            for (int32_t row = 0; row < height; ++row) {
+                size_t rowBegin = _runs.size();
+
+                int32_t col = 0;
+                while (col < width) {
+                    while (col < width && !isSet(row, col)) {
+                        col++;
+                    }
+                    if (col == width) {
+                        break;
+                    }
+                    int32_t colStart = col;
+                    while (col < width && isSet(row, col)) {
+                        col++;
+                    }
+                    auto label = (uint32_t) _parents.size();
+                    _parents.push_back(label);
+                    _runs.push_back({row, colStart, col, label});
+                }
+
+                size_t rowEnd = _runs.size();
+
+                //runs of both rows are sorted by column, so a single sweep finds all the overlaps.
+                size_t previous = previousRowBegin;
+                for (size_t current = rowBegin; current < rowEnd; ++current) {
+                    const auto &run = _runs[current];
+                    while (previous < previousRowEnd && _runs[previous].colEnd + slack <= run.colStart) {
+                        previous++;
+                    }
+                    for (size_t candidate = previous;
+                         candidate < previousRowEnd && _runs[candidate].colStart < run.colEnd + slack; ++candidate) {
+                        unite(run.label, _runs[candidate].label);
+                    }
+                }
+
+                previousRowBegin = rowBegin;
+                previousRowEnd = rowEnd;
+            }
+
+            //roots are always met before the other runs of their component.
+            _componentIds.resize(_parents.size());
+            uint32_t nbComponents = 0;
+            for (uint32_t label = 0; label < _parents.size(); ++label) {
+                auto root = find(label);
+                _componentIds[label] = (root == label) ? nbComponents++ : _componentIds[root];
+            }
+            for (auto &run : _runs) {
+                run.label = _componentIds[run.label];
+            }
+
+            return nbComponents;
+        }
+
+        /// \return the runs found during the last call to label(), in raster order.
+        const std::vector<LabeledRun> &getRuns() const {
+            return _runs;
+        }
+
+    private:
+
+        uint32_t find(uint32_t label) {
+            while (_parents[label] != label) {
+                //path halving
+                _parents[label] = _parents[_parents[label]];
+                label = _parents[label];
+            }
+            return label;
+        }
+
+        void unite(uint32_t a, uint32_t b) {
+            a = find(a);
+            b = find(b);
+            if (a < b) {
+                _parents[b] = a;
+            } else if (b < a) {
+                _parents[a] = b;
+            }
+        }
+
+        std::vector<LabeledRun> _runs{};
+        std::vector<uint32_t> _parents{};
+        std::vector<uint32_t> _componentIds{};
+    };
+}
+
+#endif //NEWEGT_RUNLENGTHLABELING_H
@@ -53,6 +53,8 @@ namespace egt {
                 return 1;
             case ImageDepth::_16U:
                 return 2;
+            case ImageDepth::_32U:
+                return 4;
             case ImageDepth::_32F:
                 return 4;
             default:
@@ -76,6 +78,49 @@ namespace egt {
         }
     };
 
+    /// Connected component labeling engine used to segment each tile.
+    enum class Labeler {
+        FLOOD,
+        RUNS
+    };
+
+    Labeler parseLabeler(const std::string &labelerString) {
+
+        if (labelerString == "flood" || labelerString == "0") {
+            return Labeler::FLOOD;
+        } else if (labelerString == "runs" || labelerString == "1") {
+            return Labeler::RUNS;
+        } else {
+            throw std::invalid_argument("labeler should be one of: 'flood','runs'");
+        }
+    };
+
+    /// Compression of the output masks. Black and white masks compressed with packbits are written with 1 bit per pixel.
+    enum class MaskCompression {
+        NONE,
+        DEFLATE,
+        LZW,
+        ZSTD,
+        PACKBITS
+    };
+
+    MaskCompression parseMaskCompression(const std::string &compressionString) {
+
+        if (compressionString == "none" || compressionString == "0") {
+            return MaskCompression::NONE;
+        } else if (compressionString == "deflate" || compressionString == "1") {
+            return MaskCompression::DEFLATE;
+        } else if (compressionString == "lzw" || compressionString == "2") {
+            return MaskCompression::LZW;
+        } else if (compressionString == "zstd" || compressionString == "3") {
+            return MaskCompression::ZSTD;
+        } else if (compressionString == "packbits" || compressionString == "4") {
+            return MaskCompression::PACKBITS;
+        } else {
+            throw std::invalid_argument("compression should be one of: 'none','deflate','lzw','zstd','packbits'");
+        }
+    };
+
 }
 
 #endif //EGT_DATATYPES_H
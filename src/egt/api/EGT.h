@@ -11,6 +11,10 @@
 #include <FastImage/api/FastImage.h>
 #include <egt/FeatureCollection/Tasks/EGTViewAnalyzer.h>
 #include <egt/FeatureCollection/Tasks/BlobMerger.h>
+#include <egt/FeatureCollection/Tasks/RegionMerger.h>
+#include <egt/FeatureCollection/Rules/RegionMergeRule.h>
+#include <egt/FeatureCollection/Rules/CompletedRegionRule.h>
+#include <htgs/api/Bookkeeper.hpp>
 #include <egt/FeatureCollection/Tasks/FeatureCollection.h>
 #include <egt/FeatureCollection/Tasks/ViewAnalyseFilter.h>
 #include "DataTypes.h"
@@ -87,6 +91,13 @@ namespace egt {
                                        ? expertModeOptions.at("loader") : 1;
             options->concurrentTiles = (expertModeOptions.find("tile") != expertModeOptions.end())
                                        ? expertModeOptions.at("tile") : 1;
+            //number of tiles whose original pixels can be held between the sobel filter and the view analyzers.
+            options->originalTilePoolSize = (expertModeOptions.find("pool") != expertModeOptions.end())
+                                            ? std::max(expertModeOptions.at("pool"), (uint32_t) 1)
+                                            : options->concurrentTiles;
+            options->nbMergeThreads = (expertModeOptions.find("merge") != expertModeOptions.end())
+                                      ? std::max(expertModeOptions.at("merge"), (uint32_t) 1)
+                                      : options->concurrentTiles;
             options->nbTilePerSample = (expertModeOptions.find("sample") != expertModeOptions.end()) ? expertModeOptions.at(
                     "sample") : -1;
             options->nbExperiments = (expertModeOptions.find("exp") != expertModeOptions.end()) ? expertModeOptions.at(
@@ -104,10 +115,50 @@ namespace egt {
 
             options->erode = (expertModeOptions.find("erode") != expertModeOptions.end())
                                       ? expertModeOptions.at("erode") == 1 : true;
+            //erode each thresholded tile in the segmentation graph, so the merged features are already eroded.
+            options->tileErode = options->erode && (expertModeOptions.find("tileerode") != expertModeOptions.end())
+                                 && expertModeOptions.at("tileerode") == 1;
+            options->nbErodeThreads = (expertModeOptions.find("erodethreads") != expertModeOptions.end())
+                                      ? std::max(expertModeOptions.at("erodethreads"), (uint32_t) 1)
+                                      : options->concurrentTiles;
+
+            options->labeler = (expertModeOptions.find("labeler") != expertModeOptions.end())
+                               ? static_cast<Labeler>(expertModeOptions.at("labeler")) : Labeler::FLOOD;
+
+            options->maskCompression = (expertModeOptions.find("compression") != expertModeOptions.end())
+                                       ? static_cast<MaskCompression>(expertModeOptions.at("compression"))
+                                       : MaskCompression::NONE;
+            //reduced resolution levels of the output mask, written as sub-IFDs by the streaming writers.
+            options->nbMaskPyramidLevels = (expertModeOptions.find("pyramid") != expertModeOptions.end())
+                                           ? expertModeOptions.at("pyramid") : 0;
+
+            //memory budget in MB for the decoded tiles shared by all the phases.
+            uint32_t tileCacheSize = (expertModeOptions.find("cache") != expertModeOptions.end())
+                                     ? expertModeOptions.at("cache") : 0;
+            if (tileCacheSize > 0) {
+                options->tileCache = std::make_shared<TiffTileCache>((uint64_t) tileCacheSize * 1024 * 1024);
+            }
+
+            //threads reading the compressed tiles, the loader threads then only decode them.
+            uint32_t nbIoThreads = (expertModeOptions.find("io") != expertModeOptions.end())
+                                   ? expertModeOptions.at("io") : 0;
+            uint32_t readAhead = (expertModeOptions.find("readahead") != expertModeOptions.end())
+                                 ? expertModeOptions.at("readahead") : 2 * (uint32_t) options->nbLoaderThreads;
+#ifndef EGT_RAW_TILE_DECODE
+            if (nbIoThreads > 0) {
+                LOG(WARNING) << "io=<n> needs libtiff 4.1.0 or later, the loader threads read the tiles.";
+                nbIoThreads = 0;
+            }
+#endif
+            if (nbIoThreads > 0) {
+                options->rawTileReader = std::make_shared<RawTileReader>(options->inputPath, nbIoThreads, readAhead);
+            }
 
             VLOG(1) << "Execution model : ";
             VLOG(1) << "loader threads : " << options->nbLoaderThreads;
             VLOG(1) << "concurrent tiles : " << options->concurrentTiles;
+            VLOG(1) << "original tiles pool size : " << options->originalTilePoolSize;
+            VLOG(1) << "merge threads : " << options->nbMergeThreads;
             VLOG(1) << "fixed threshold : " << std::boolalpha << (options->threshold != -1);
             if (options->threshold != -1) {
                 VLOG(1) << "fixed threshold value : " << options->threshold << std::endl;
@@ -121,13 +172,31 @@ namespace egt {
             }
             VLOG(1) << "min and max intensity are calculated at pyramid level: " << options->pixelIntensityBoundsLevelUp;
             VLOG(1) << "performing erosion: " << std::boolalpha << options->erode;
+            VLOG(1) << "erosion threads : " << options->nbErodeThreads;
+            VLOG(1) << "erosion of the tiles : " << std::boolalpha << options->tileErode;
+            VLOG(1) << "tile labeling : " << ((options->labeler == Labeler::RUNS) ? "runs" : "flood");
+            VLOG(1) << "mask compression : " << (uint32_t) options->maskCompression;
+            VLOG(1) << "mask pyramid levels : " << options->nbMaskPyramidLevels;
+            VLOG(1) << "decoded tile cache (MB) : " << tileCacheSize;
+            VLOG(1) << "I/O threads : " << nbIoThreads;
+            if (nbIoThreads > 0) {
+                VLOG(1) << "tiles read ahead : " << readAhead;
+            }
 
 
             //We need to derive the segmentations params from the user defined parameters
+            auto segmentationParams = DerivedSegmentationParams<T>();
+
+            //When both passes read every tile of the same pyramid level, intensity bounds and threshold
+            //are computed from a single read of the image.
+            bool fusedPass = !segmentationOptions->disableIntensityFilter && options->threshold == -1
+                    && options->pixelIntensityBoundsLevelUp == 0
+                    && options->nbTilePerSample == -1 && options->nbExperiments == -1;
+            VLOG(1) << "fused intensity bounds and threshold pass: " << std::boolalpha << fusedPass;
+
             auto beginIntensityFilter = std::chrono::high_resolution_clock::now();
             //Finding intensity bounds.
-            auto segmentationParams = DerivedSegmentationParams<T>();
-            if(! segmentationOptions->disableIntensityFilter) {
+            if(! segmentationOptions->disableIntensityFilter && ! fusedPass) {
                auto intensityFinder = new PixelIntensityBoundsFinder<T>();
                intensityFinder->runFastPixelIntensityBounds(options, segmentationOptions, segmentationParams);
                delete intensityFinder;
@@ -137,7 +206,13 @@ namespace egt {
             //Finding gradient threshold pixel value.
             auto beginThreshold = std::chrono::high_resolution_clock::now();
             T threshold{};
-            if (options->threshold == -1) {
+            if (fusedPass) {
+                auto intensityHistogram = std::make_shared<IntensityHistogram>(PixelIntensityBoundsFinder<T>::NB_INTENSITY_BINS);
+                threshold = runThresholdFinder(options, intensityHistogram);
+                auto intensityFinder = new PixelIntensityBoundsFinder<T>();
+                intensityFinder->computePixelIntensityBounds(*intensityHistogram, segmentationOptions, segmentationParams);
+                delete intensityFinder;
+            } else if (options->threshold == -1) {
                 threshold = runThresholdFinder(options);
             } else {
                 threshold = options->threshold;
@@ -158,7 +233,7 @@ namespace egt {
             //Mask generation
             auto beginFC = std::chrono::high_resolution_clock::now();
             if (!segmentationOptions->MASK_ONLY) {
-                if(options->erode) {
+                if(options->erode && !options->tileErode) {
                     blobs->erode(options, segmentationOptions);
                 }
                 runMaskGeneration(blobs, options, segmentationOptions);
@@ -177,10 +252,22 @@ namespace egt {
                     << " mS";
             VLOG(1) << "    Segmentation: " << std::chrono::duration_cast<std::chrono::milliseconds>(
                     endSegmentation - beginSegmentation).count() << " mS";
+            VLOG(1) << "        Blob Merge: " << mergeDuration.count() << " mS";
             VLOG(1) << "    Feature Collection: "
                     << std::chrono::duration_cast<std::chrono::milliseconds>(endFC - beginFC).count() << " mS";
             VLOG(1) << "    Total: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count()
                     << " mS" << std::endl;
+
+            if (options->tileCache != nullptr) {
+                VLOG(1) << "Tile cache : " << options->tileCache->getHits() << " hits, "
+                        << options->tileCache->getMisses() << " misses.";
+                options->tileCache.reset();
+            }
+            if (options->rawTileReader != nullptr) {
+                VLOG(1) << "Raw tile reader : " << options->rawTileReader->getBytesRead() << " bytes read, "
+                        << options->rawTileReader->getHits() << " tiles read ahead.";
+                options->rawTileReader.reset();
+            }
         }
 
 
@@ -188,14 +275,16 @@ namespace egt {
         /// ----------------------------------
         /// The first graph finds the threshold value used to segment the image
         /// ----------------------------------
-        T runThresholdFinder(EGTOptions *options) {
+        /// \param intensityHistogram if not null, pixel intensities are also collected during this pass.
+        T runThresholdFinder(EGTOptions *options, std::shared_ptr<IntensityHistogram> intensityHistogram = nullptr) {
 
             const uint32_t pyramidLevelToRequestforThreshold = options->pyramidLevel;
             const uint32_t radiusForThreshold = 1;
 
             T threshold = 0;
 
-            auto tileLoader = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads);
+            auto tileLoader = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads, options->tileCache,
+                                                            options->rawTileReader);
             auto *fi = new fi::FastImage<T>(tileLoader, radiusForThreshold);
             fi->getFastImageOptions()->setNumberOfViewParallel(options->concurrentTiles);
             auto fastImage = fi->configureAndMoveToTaskGraphTask("Fast Image");
@@ -222,7 +311,7 @@ namespace egt {
             VLOG(1) << "Threshold finder. Nb of experiments: " << nbOfSamplingExperiment << std::endl;
 
             auto graph = new htgs::TaskGraphConf<htgs::MemoryData<fi::View<T>>, Threshold<T>>();
-            auto sobelFilter = new CustomSobelFilter3by3<T>(options->concurrentTiles, options->imageDepth, 1, 1);
+            auto sobelFilter = new CustomSobelFilter3by3<T>(options->concurrentTiles, options->imageDepth, 1, 1, intensityHistogram);
 
             auto thresholdFinder = new FastThresholdFinder<T>(nbOfSamplingExperiment, tileHeight * tileWidth, nbOfSamples,
                                                           options->imageDepth);
@@ -309,9 +398,11 @@ namespace egt {
             uint32_t pyramidLevelToRequestForSegmentation = options->pyramidLevel;
             //radius of 2 since we need first apply convo, obtain a gradient of size n+1,
             //and then check the ghost region for potential merges for each tile of size n.
+            //Masks generated locally are never eroded, so the tiles are not eroded either.
             uint32_t segmentationRadius = 2;
 
-            auto tileLoader2 = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads);
+            auto tileLoader2 = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads, options->tileCache,
+                                                             options->rawTileReader);
             auto *fi = new fi::FastImage<T>(tileLoader2, segmentationRadius);
             fi->getFastImageOptions()->setNumberOfViewParallel(options->concurrentTiles);
             auto fastImageTask = fi->configureAndMoveToTaskGraphTask("Fast Image");
@@ -319,8 +410,6 @@ namespace egt {
             uint32_t imageWidthAtSegmentationLevel = fi->getImageWidth(pyramidLevelToRequestForSegmentation);
             int32_t tileHeigthAtSegmentationLevel = fi->getTileHeight(pyramidLevelToRequestForSegmentation);
             int32_t tileWidthAtSegmentationLevel = fi->getTileWidth(pyramidLevelToRequestForSegmentation);
-            uint32_t nbTiles = fi->getNumberTilesHeight(pyramidLevelToRequestForSegmentation) *
-                               fi->getNumberTilesWidth(pyramidLevelToRequestForSegmentation);
 
             auto sobelFilter2 = new EGTSobelFilter<T>(options->concurrentTiles, options->imageDepth, 1, 1);
             auto viewSegmentation = new EGTGradientViewAnalyzer<T>(options->concurrentTiles,
@@ -331,21 +420,25 @@ namespace egt {
                                                            options->rank,
                                                            threshold,
                                                            segmentationOptions,
-                                                           segmentationParams);
+                                                           segmentationParams,
+                                                           options->labeler,
+                                                           false);
             auto maskFilter = new ViewFilter<T>(options->concurrentTiles);
             auto merge = new BlobMerger<T>(imageHeightAtSegmentationLevel,
                                         imageWidthAtSegmentationLevel,
-                                        nbTiles,
+                                        (uint32_t) tileHeigthAtSegmentationLevel,
+                                        (uint32_t) tileWidthAtSegmentationLevel,
                                         options,
                                         segmentationOptions,
                                         segmentationParams);
             auto writeMask = new TiffTileWriter<T>(
-                    1,
+                    options->concurrentTiles,
                     imageHeightAtSegmentationLevel,
                     imageWidthAtSegmentationLevel,
                     (uint32_t) tileHeigthAtSegmentationLevel,
                     ImageDepth::_8U,
-                    (fs::path(options->outputPath) / "mask.tif").string()
+                    (fs::path(options->outputPath) / "mask.tif").string(),
+                    options->maskCompression
             );
 
             localMaskGenerationGraph = new htgs::TaskGraphConf<htgs::MemoryData<fi::View<T>>, VoidData>;
@@ -353,6 +446,12 @@ namespace egt {
             localMaskGenerationGraph->addEdge(sobelFilter2, viewSegmentation);
             localMaskGenerationGraph->addEdge(viewSegmentation, maskFilter);
             localMaskGenerationGraph->addEdge(maskFilter, writeMask);
+
+            //MEMORY MANAGEMENT
+            localMaskGenerationGraph->addMemoryManagerEdge("originalTile", sobelFilter2,
+                                                           new TileAllocator<T>(tileWidthAtSegmentationLevel,
+                                                                                tileHeigthAtSegmentationLevel),
+                                                           options->originalTilePoolSize, htgs::MMType::Static);
             localMaskGenerationGraphRuntime = new htgs::TaskGraphRuntime(localMaskGenerationGraph);
             localMaskGenerationGraphRuntime->executeRuntime();
             fi->requestAllTiles(true, pyramidLevelToRequestForSegmentation);
@@ -380,9 +479,11 @@ namespace egt {
             uint32_t pyramidLevelToRequestForSegmentation = options->pyramidLevel;
             //radius of 2 since we need first apply convo, obtain a gradient of size n+1,
             //and then check the ghost region for potential merges for each tile of size n.
-            uint32_t segmentationRadius = 2;
+            //Eroding the tiles needs one more pixel of gradient around the ghost region.
+            uint32_t segmentationRadius = options->tileErode ? 3 : 2;
 
-            auto tileLoader2 = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads);
+            auto tileLoader2 = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads, options->tileCache,
+                                                             options->rawTileReader);
             auto *fi = new fi::FastImage<T>(tileLoader2, segmentationRadius);
             fi->getFastImageOptions()->setNumberOfViewParallel(options->concurrentTiles);
             auto fastImage2 = fi->configureAndMoveToTaskGraphTask("Fast Image 2");
@@ -390,8 +491,6 @@ namespace egt {
             imageWidthAtSegmentationLevel = fi->getImageWidth(pyramidLevelToRequestForSegmentation);
             tileHeightAtSegmentationLevel = fi->getTileHeight(pyramidLevelToRequestForSegmentation);
             tileWidthAtSegmentationLevel = fi->getTileWidth(pyramidLevelToRequestForSegmentation);
-            uint32_t nbTiles = fi->getNumberTilesHeight(pyramidLevelToRequestForSegmentation) *
-                               fi->getNumberTilesWidth(pyramidLevelToRequestForSegmentation);
             auto sobelFilter2 = new EGTSobelFilter<T>(options->concurrentTiles, options->imageDepth, 1, 1);
 
             auto viewSegmentation = new EGTGradientViewAnalyzer<T>(options->concurrentTiles,
@@ -402,11 +501,30 @@ namespace egt {
                                                            options->rank,
                                                            threshold,
                                                            segmentationOptions,
-                                                           segmentationParams);
+                                                           segmentationParams,
+                                                           options->labeler,
+                                                           options->tileErode);
             auto labelingFilter = new ViewAnalyseFilter<T>(options->concurrentTiles);
+            //tile analyses are merged 2x2 regions at a time until a single region covers the whole image
+            auto mergeBookkeeper = new htgs::Bookkeeper<ViewAnalyse>();
+            auto regionMergeRule = new RegionMergeRule(imageHeightAtSegmentationLevel,
+                                                       imageWidthAtSegmentationLevel,
+                                                       (uint32_t) tileHeightAtSegmentationLevel,
+                                                       (uint32_t) tileWidthAtSegmentationLevel);
+            //each region sends the blobs it completed to be filtered, they do not go up the merge tree
+            auto completedRegionRule = new CompletedRegionRule(imageHeightAtSegmentationLevel,
+                                                               imageWidthAtSegmentationLevel,
+                                                               (uint32_t) tileHeightAtSegmentationLevel,
+                                                               (uint32_t) tileWidthAtSegmentationLevel);
+            auto regionMerger = new RegionMerger(options->nbMergeThreads,
+                                                 imageHeightAtSegmentationLevel,
+                                                 imageWidthAtSegmentationLevel,
+                                                 (uint32_t) tileHeightAtSegmentationLevel,
+                                                 (uint32_t) tileWidthAtSegmentationLevel);
             auto merge = new BlobMerger<T>(imageHeightAtSegmentationLevel,
                                         imageWidthAtSegmentationLevel,
-                                        nbTiles,
+                                        (uint32_t) tileHeightAtSegmentationLevel,
+                                        (uint32_t) tileWidthAtSegmentationLevel,
                                         options,
                                         segmentationOptions,
                                         segmentationParams);
@@ -414,9 +532,18 @@ namespace egt {
             segmentationGraph->addEdge(fastImage2, sobelFilter2);
             segmentationGraph->addEdge(sobelFilter2, viewSegmentation);
             segmentationGraph->addEdge(viewSegmentation, labelingFilter);
-            segmentationGraph->addEdge(labelingFilter, merge);
+            segmentationGraph->addEdge(labelingFilter, mergeBookkeeper);
+            segmentationGraph->addRuleEdge(mergeBookkeeper, regionMergeRule, regionMerger);
+            segmentationGraph->addEdge(regionMerger, mergeBookkeeper);
+            segmentationGraph->addRuleEdge(mergeBookkeeper, completedRegionRule, merge);
             segmentationGraph->addGraphProducerTask(merge);
 
+            //MEMORY MANAGEMENT
+            segmentationGraph->addMemoryManagerEdge("originalTile", sobelFilter2,
+                                                    new TileAllocator<T>(tileWidthAtSegmentationLevel,
+                                                                         tileHeightAtSegmentationLevel),
+                                                    options->originalTilePoolSize, htgs::MMType::Static);
+
             htgs::TaskGraphSignalHandler::registerTaskGraph(segmentationGraph);
             htgs::TaskGraphSignalHandler::registerSignal(SIGTERM);
 
@@ -428,6 +555,7 @@ namespace egt {
             //we only generate one output, the list of all objects
             std::shared_ptr<ListBlobs> blobs = segmentationGraph->consumeData();
             segmentationRuntime->waitForRuntime();
+            mergeDuration = merge->getMergeDuration();
             delete fi;
             delete segmentationRuntime;
             return blobs;
@@ -439,10 +567,6 @@ namespace egt {
             auto fc = new FeatureCollection();
             fc->createFCFromCompactListBlobs(blob.get(), imageHeightAtSegmentationLevel, imageWidthAtSegmentationLevel);
 
-            //TODO CHECK WHAT TO DO. This is the fast way of writing a image but also memory hungry (needs to load all tiles in memory).
-            //TODO should we make it an option?
-       //     fc->createBlackWhiteMask("output.tiff", (uint32_t) tileWidthAtSegmentationLevel);
-
             fs::path path = options->inputPath;
             std::string inputFilename = path.filename();
             std::string outputFilenamePrefix = "";
@@ -461,25 +585,32 @@ namespace egt {
                 auto outputFilepath =  (fs::path(options->outputPath) / outputFilename).string();
 
 
-                if(options->streamingWrite) {
+                //only the streaming writers rasterize the pyramid levels
+                if(options->streamingWrite || options->nbMaskPyramidLevels > 0) {
                     if (nbBlobs < 256) {
                         depth = ImageDepth::_8U;
                         fc->createLabeledMaskStreaming<uint8_t>(outputFilepath,
                                                                 (uint32_t) tileWidthAtSegmentationLevel,
-                                                                depth);
+                                                                depth, options->concurrentTiles,
+                                                                options->maskCompression,
+                                                                options->nbMaskPyramidLevels);
                     } else if (nbBlobs < 256 * 256) {
                         depth = ImageDepth::_16U;
                         fc->createLabeledMaskStreaming<uint16_t>(outputFilepath,
                                                                  (uint32_t) tileWidthAtSegmentationLevel,
-                                                                 depth);
+                                                                 depth, options->concurrentTiles,
+                                                                 options->maskCompression,
+                                                                 options->nbMaskPyramidLevels);
                     } else {
                         fc->createLabeledMaskStreaming<uint32_t>(outputFilepath,
                                                                  (uint32_t) tileWidthAtSegmentationLevel,
-                                                                 depth);
+                                                                 depth, options->concurrentTiles,
+                                                                 options->maskCompression,
+                                                                 options->nbMaskPyramidLevels);
                     }
                 }
                 else {
-                    fc->createLabeledMask(outputFilepath);
+                    fc->createLabeledMask(outputFilepath, 1024, options->maskCompression);
                 }
             }
             else {
@@ -487,11 +618,15 @@ namespace egt {
                 auto outputFilename = outputFilenamePrefix + inputFilename;
                 auto outputFilepath =  (fs::path(options->outputPath) / outputFilename).string();
 
-                if(options->streamingWrite) {
-                    fc->createBlackWhiteMaskStreaming(outputFilepath, (uint32_t) tileWidthAtSegmentationLevel);
+                //only the streaming writers rasterize the pyramid levels
+                if(options->streamingWrite || options->nbMaskPyramidLevels > 0) {
+                    fc->createBlackWhiteMaskStreaming(outputFilepath, (uint32_t) tileWidthAtSegmentationLevel,
+                                                      options->concurrentTiles, options->maskCompression,
+                                                      options->nbMaskPyramidLevels);
                 }
                 else{
-                    fc->createBlackWhiteMask(outputFilepath, (uint32_t) tileWidthAtSegmentationLevel);
+                    fc->createBlackWhiteMask(outputFilepath, (uint32_t) tileWidthAtSegmentationLevel,
+                                             options->maskCompression);
                 }
             }
 
@@ -499,110 +634,13 @@ namespace egt {
         }
 
 
-        void computeMeanIntensities(std::shared_ptr<ListBlobs> &blobs, EGTOptions *options) {
-
-            const uint32_t pyramidLevelToRequestforThreshold = options->pyramidLevel;
-            const uint32_t radiusForFeatureExtraction = 0;
-
-            auto tileLoader = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads);
-            auto *fi = new fi::FastImage<T>(tileLoader, radiusForFeatureExtraction);
-            fi->getFastImageOptions()->setNumberOfViewParallel(options->concurrentTiles);
-            fi->configureAndRun();
-
-            uint32_t
-                    indexRowMin = 0,
-                    indexRowMax = 0,
-                    indexColMin = 0,
-                    indexColMax = 0;
-
-            uint32_t
-                    minRow = 0,
-                    maxRow = 0,
-                    minCol = 0,
-                    maxCol = 0;
-
-            for (auto blob : blobs->_blobs) {
-                T pixValue = 0,
-                        featureMeanIntensity = 0;
-                uint64_t count = 0;
-                uint64_t sum = 0;
-                uint32_t featureTotalTileCount = 0;
-
-                auto feature = blob->getFeature();
-
-                //We cannot use fc::feature because we reimplemented it in the egt namespace
-                //let's request all tiles for each feature
-                const auto &bb = feature->getBoundingBox();
-                indexRowMin = bb.getUpperLeftRow() / fi->getTileHeight();
-                indexColMin = bb.getUpperLeftCol() / fi->getImageWidth();
-                // Handle border case
-                if (bb.getBottomRightCol() == fi->getImageWidth())
-                    indexColMax = fi->getNumberTilesWidth();
-                else
-                    indexColMax = (bb.getBottomRightCol() / fi->getTileWidth()) + 1;
-                if (bb.getBottomRightRow() == fi->getImageHeight())
-                    indexRowMax = fi->getNumberTilesHeight();
-                else
-                    indexRowMax = (bb.getBottomRightRow() / fi->getTileHeight()) + 1;
-                for (auto indexRow = indexRowMin; indexRow < indexRowMax; ++indexRow) {
-                    for (auto indexCol = indexColMin; indexCol < indexColMax; ++indexCol) {
-                        fi->requestTile(indexRow,indexCol, false);
-                        featureTotalTileCount++;
-                    }
-                }
-
-                auto tileCount = 0;
-
-                while (tileCount < featureTotalTileCount) {
-                    auto view = fi->getAvailableViewBlocking();
-                    if (view != nullptr) {
-                        minRow = std::max(view->get()->getGlobalYOffset(),
-                                          feature->getBoundingBox().getUpperLeftRow());
-                        maxRow = std::min(
-                                view->get()->getGlobalYOffset() + view->get()->getTileHeight(),
-                                feature->getBoundingBox().getBottomRightRow());
-                        minCol = std::max(view->get()->getGlobalXOffset(),
-                                          feature->getBoundingBox().getUpperLeftCol());
-                        maxCol = std::min(
-                                view->get()->getGlobalXOffset() + view->get()->getTileWidth(),
-                                feature->getBoundingBox().getBottomRightCol());
-
-                        for (auto row = minRow; row < maxRow; ++row) {
-                            for (auto col = minCol; col < maxCol; ++col) {
-                                if (feature->isImagePixelInBitMask(row, col)) {
-                                    pixValue = view->get()->getPixel(
-                                            row - view->get()->getGlobalYOffset(),
-                                            col - view->get()->getGlobalXOffset());
-                                    sum += pixValue;
-                                    count++;
-                                }
-                            }
-                        }
-                        view->releaseMemory();
-                        tileCount ++;
-                    }
-                }
-
-                assert(count != 0);
-                assert(sum != 0);
-                featureMeanIntensity = std::round(sum / count);
-                meanIntensities[blob] = featureMeanIntensity;
-            }
-
-            fi->finishedRequestingTiles();
-            fi->waitForGraphComplete();
-            delete fi;
-        }
-
-
     private:
         uint32_t imageHeightAtSegmentationLevel{},
                 imageWidthAtSegmentationLevel{},
                 tileWidthAtSegmentationLevel{},
                 tileHeightAtSegmentationLevel{};
 
-
-        std::map<Blob*, T> meanIntensities{};
+        std::chrono::milliseconds mergeDuration{};
 
 
     };
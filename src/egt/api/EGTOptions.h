@@ -6,6 +6,8 @@
 #define NEWEGT_EGTOPTIONS_H
 
 #include "DataTypes.h"
+#include <egt/loaders/TiffTileCache.h>
+#include <egt/loaders/RawTileReader.h>
 
 namespace egt {
 
@@ -21,6 +23,9 @@ namespace egt {
 
         size_t nbLoaderThreads{};
         uint32_t concurrentTiles{};
+        uint32_t originalTilePoolSize{};
+        uint32_t nbMergeThreads{};
+        uint32_t nbErodeThreads{};
 
         int32_t nbTilePerSample = -1;
         int32_t nbExperiments = -1;
@@ -35,6 +40,18 @@ namespace egt {
 
         bool erode{};
 
+        bool tileErode{};
+
+        Labeler labeler = Labeler::FLOOD;
+
+        MaskCompression maskCompression = MaskCompression::NONE;
+
+        uint32_t nbMaskPyramidLevels{};
+
+        std::shared_ptr<TiffTileCache> tileCache{};
+
+        std::shared_ptr<RawTileReader> rawTileReader{};
+
     };
 }
 
@@ -8,34 +8,39 @@
 #include <FastImage/api/View.h>
 #include <htgs/api/IData.hpp>
 #include <htgs/api/MemoryData.hpp>
+#include <htgs/types/Types.hpp>
 
 namespace egt {
 
+    /// \brief Gradient of a view, along with the original pixels of its tile.
+    /// The original pixels come from the "originalTile" memory manager and must be released once used.
     template <class T>
     class GradientView : htgs::IData {
 
     public :
 
-        GradientView(const std::shared_ptr<htgs::MemoryData<fi::View<T>>> &gradientView, T*originalView) : gradientView(gradientView),
-                                                                                          originalView(originalView) {}
-
-        ~GradientView() override {
-            delete[] originalView;
-        }
+        GradientView(const std::shared_ptr<htgs::MemoryData<fi::View<T>>> &gradientView, htgs::m_data_t<T> originalTile) :
+                gradientView(gradientView), originalTile(originalTile) {}
 
         const std::shared_ptr<MemoryData<fi::View<T>>> &getGradientView() const {
             return gradientView;
         }
 
+        /// \brief Get the original pixels of the tile, stored row by row with a stride of tileWidth.
         T *getOriginalView() const {
-            return originalView;
+            return originalTile->get();
+        }
+
+        /// \brief Give the original pixels back to their memory manager.
+        void releaseOriginalView() {
+            originalTile->releaseMemory();
         }
 
 
     private:
 
         std::shared_ptr<htgs::MemoryData<fi::View<T>>> gradientView = nullptr;
-        T * originalView;
+        htgs::m_data_t<T> originalTile = nullptr;
 
 
     };
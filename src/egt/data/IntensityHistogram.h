@@ -0,0 +1,48 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_INTENSITYHISTOGRAM_H
+#define NEWEGT_INTENSITYHISTOGRAM_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace egt {
+
+    /**
+     * Histogram of pixel intensities filled concurrently by several tasks.
+     * Each task bins its tiles locally and adds its bins once done.
+     */
+    class IntensityHistogram {
+
+    public:
+
+        /// \brief IntensityHistogram constructor
+        /// \param nbBins Number of bins, one per pixel intensity value
+        explicit IntensityHistogram(size_t nbBins) : _bins(nbBins, 0) {}
+
+        /// \brief Add bins collected by a task
+        /// \param bins Bins to add, same size as the histogram
+        void add(const std::vector<uint64_t> &bins) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (size_t k = 0; k < _bins.size(); k++) {
+                _bins[k] += bins[k];
+            }
+        }
+
+        /// \return Number of bins
+        size_t getNbBins() const { return _bins.size(); }
+
+        /// \return Number of pixels for each intensity value
+        const std::vector<uint64_t> &getBins() const { return _bins; }
+
+    private:
+        std::vector<uint64_t> _bins{};
+
+        std::mutex _mutex{};
+    };
+}
+
+#endif //NEWEGT_INTENSITYHISTOGRAM_H
@@ -51,13 +51,32 @@
 
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <vector>
 #include "FastImage/api/ATileLoader.h"
 #include "FastImage/data/DataType.h"
 #include "FastImage/object/FigCache.h"
+#include "TiffTileCache.h"
+#include "RawTileReader.h"
+#include <egt/utils/PixelConversion.h>
 
 namespace egt {
 /// \namespace fi FastImage namespace
 
+    /// \brief Tile read statistics, shared by a tile loader and all its copies.
+    struct TileLoaderCounters {
+        std::atomic<uint64_t>
+                tilesRead{0},           ///< Number of tiles read from the file
+                cachedTiles{0},         ///< Number of tiles found in the decoded tiles cache
+                bytesRead{0},           ///< Number of bytes of the tiles stored in the file
+                bytesDecoded{0},        ///< Number of bytes of the decoded tiles
+                directorySwitches{0},   ///< Number of times a loader changed of pyramid level
+                decodeDuration{0},      ///< Time spent reading and decoding tiles, in nS
+                convertDuration{0};     ///< Time spent converting tiles to the user type, in nS
+    };
+
 /**
    * @class PyramidTiledTiffLoader PyramidTiledTiffLoader.h
    *
@@ -91,10 +110,22 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
         /// These metadata are used to check if the file is tiles and in grayscale.
         /// \param fileName File path
         /// \param numThreads Number of threads used by the tiff tile loader
+        /// \param tileCache Decoded tiles cache shared with other loaders of the same file, disabled if nullptr
+        /// \param rawTileReader I/O threads reading the compressed tiles, which the loader threads then only decode.
+        /// If nullptr, each loader thread reads and decodes its tiles with libtiff.
         explicit PyramidTiledTiffLoader(const std::string &fileName,
-                                     size_t numThreads = 1)
+                                     size_t numThreads = 1,
+                                     std::shared_ptr<TiffTileCache> tileCache = nullptr,
+                                     std::shared_ptr<RawTileReader> rawTileReader = nullptr)
                 : fi::ATileLoader<UserType>(fileName,
-                                        numThreads) {
+                                        numThreads), _tileCache(std::move(tileCache)),
+                  _rawTileReader(std::move(rawTileReader)),
+                  _counters(std::make_shared<TileLoaderCounters>()) {
+
+            //each loader is built for a new pass over the image, its copies share the pass
+            if (_rawTileReader != nullptr) {
+                _rawTileReader->beginPass();
+            }
 
             // Open the file
             _tiff = TIFFOpen(fileName.c_str(), "r");
@@ -122,6 +153,7 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
                 _samplesPerPixels = new uint16_t[_numPyramidLevels];
                 _bitsPerSamples = new uint16_t[_numPyramidLevels];
                 _sampleFormats = new uint16_t[_numPyramidLevels];
+                _directoryOffsets = new uint64_t[_numPyramidLevels];
 
                 // Load/parse header for each directory (pyramid level)
                 for (uint32_t pyramidLevel = 0; pyramidLevel < _numPyramidLevels; pyramidLevel++) {
@@ -132,6 +164,7 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
                                 << "pyramidLevel = " << pyramidLevel;
                         throw (fi::FastImageException(message.str()));
                     }
+                    _directoryOffsets[pyramidLevel] = TIFFCurrentDirOffset(_tiff);
 
                     if (!TIFFGetField(_tiff, TIFFTAG_IMAGEWIDTH, &(_imageWidths[pyramidLevel]))) {
                         throw (fi::FastImageException("Tile Loader ERROR: TIFFTAG_IMAGEWIDTH not defined"));
@@ -175,6 +208,8 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
                         _sampleFormats[pyramidLevel] = SAMPLEFORMAT_UINT;
                     }
                 }
+                _currentLevel = _numPyramidLevels - 1;
+                TIFFGetField(_tiff, TIFFTAG_TILEBYTECOUNTS, &_tileByteCounts);
             }
             else {
                 std::stringstream message;
@@ -190,6 +225,16 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
                 TIFFClose(_tiff);
             }
 
+            //the last loader reports the reads of all the copies
+            if (_counters.use_count() == 1 && _counters->tilesRead + _counters->cachedTiles > 0) {
+                VLOG(2) << "Tile loader: " << _counters->tilesRead << " tiles read (" << _counters->bytesRead
+                        << " bytes in file, " << _counters->bytesDecoded << " bytes decoded), "
+                        << _counters->cachedTiles << " tiles from cache, "
+                        << _counters->directorySwitches << " directory switches, decode "
+                        << _counters->decodeDuration / 1000000 << " mS, convert "
+                        << _counters->convertDuration / 1000000 << " mS";
+            }
+
             delete[] _imageWidths;
             delete[] _imageHeights;
             delete[] _tileWidths;
@@ -200,6 +245,13 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
             delete[] _samplesPerPixels;
             delete[] _bitsPerSamples;
             delete[] _sampleFormats;
+            delete[] _directoryOffsets;
+        }
+
+        /// \brief Get the tile read statistics of this loader and all its copies
+        /// \return Tile read statistics
+        const TileLoaderCounters &getCounters() const {
+            return *_counters;
         }
 
         /// \brief Get Image height
@@ -266,10 +318,7 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
         /// \param dest Tile buffer
         template<typename FileType>
         void loadTile(tdata_t src, UserType *dest, uint32_t numSamples) {
-            for (uint32_t sampleNum = 0; sampleNum < numSamples; ++sampleNum) {
-                dest[sampleNum] =
-                        (UserType) ((FileType *) (src))[sampleNum];
-            }
+            PixelConversion::convert((const FileType *) src, dest, numSamples);
         }
 
         /// \brief Get down scale Factor for pyramid images. The tiff image for this
@@ -281,9 +330,8 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
         }
 
         /// \brief Load a tile from the disk
-        /// \details Allocate a buffer, load a tile from the file into the buffer,
-        /// cast each pixel to the right format into parameter tile, and close
-        /// the buffer.
+        /// \details Load a tile from the file into the reusable decode buffer,
+        /// and cast each pixel to the right format into parameter tile.
         /// \param tile Pointer to a tile already allocated to fill
         /// \param indexRowGlobalTile Row index tile asked
         /// \param indexColGlobalTile Column Index tile asked
@@ -306,26 +354,38 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
                                 uint32_t indexColGlobalTile,
                                 uint32_t pyramidLevel) {
 
-            int setDirectoryStatus = TIFFSetDirectory(_tiff, pyramidLevel);
-
-            if (setDirectoryStatus != 1) {
-                std::stringstream message;
-                message
-                        << "Tile Loader ERROR: TIFFSetDirectory error in loadTileFromFile with "
-                        << "pyramidLevel = " << pyramidLevel;
-                throw (fi::FastImageException(message.str()));
+            //tile already decoded by another loader
+            if (_tileCache != nullptr) {
+                auto cachedTile = _tileCache->get(pyramidLevel, indexRowGlobalTile, indexColGlobalTile);
+                if (cachedTile != nullptr) {
+                    convertTileAndCount((tdata_t) cachedTile->data(), tile, pyramidLevel);
+                    _counters->cachedTiles++;
+                    return 0;
+                }
             }
 
-            tdata_t tiffTile = _TIFFmalloc(TIFFTileSize(_tiff));
+            setLevel(pyramidLevel);
+
+            //tiles already in UserType are decoded straight into the tile buffer,
+            //others in the decode buffer which only grows, so reads at the same level do not allocate
+            auto tileSize = TIFFTileSize(_tiff);
+            bool decodeInPlace = isUserTypeLayout(pyramidLevel, tileSize);
+            if (!decodeInPlace && _tiffTile.size() < (size_t) tileSize) {
+                _tiffTile.resize((size_t) tileSize);
+            }
+            tdata_t tiffTile = decodeInPlace ? (tdata_t) tile : (tdata_t) _tiffTile.data();
 
             auto begin = std::chrono::high_resolution_clock::now();
 
-            tsize_t numBytesRead = TIFFReadTile(_tiff,
-                                                tiffTile,
-                                                indexColGlobalTile * _tileWidths[pyramidLevel],
-                                                indexRowGlobalTile * _tileHeights[pyramidLevel],
-                                                0,
-                                                0);
+            tsize_t numBytesRead = (_rawTileReader != nullptr)
+                                   ? decodeRawTile(tiffTile, tileSize, indexRowGlobalTile, indexColGlobalTile,
+                                                   pyramidLevel)
+                                   : TIFFReadTile(_tiff,
+                                                  tiffTile,
+                                                  indexColGlobalTile * _tileWidths[pyramidLevel],
+                                                  indexRowGlobalTile * _tileHeights[pyramidLevel],
+                                                  0,
+                                                  0);
 
             if (numBytesRead == -1) {
                 std::stringstream message;
@@ -342,6 +402,32 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
             double diskDuration = (double)(std::chrono::duration_cast<std::chrono::nanoseconds>(
                     end - begin).count());
 
+            _counters->tilesRead++;
+            _counters->bytesDecoded += (uint64_t) numBytesRead;
+            _counters->decodeDuration += (uint64_t) diskDuration;
+            if (_tileByteCounts != nullptr) {
+                _counters->bytesRead += _tileByteCounts[indexRowGlobalTile * _numTilesWidths[pyramidLevel]
+                                                        + indexColGlobalTile];
+            }
+
+            if (_tileCache != nullptr) {
+                _tileCache->put(pyramidLevel, indexRowGlobalTile, indexColGlobalTile, tiffTile,
+                                (uint64_t) tileSize);
+            }
+
+            if (!decodeInPlace) {
+                convertTileAndCount(tiffTile, tile, pyramidLevel);
+            }
+
+            return diskDuration;
+        }
+
+        /// \brief Convert a tile from the file sample format to UserType
+        /// \param tiffTile Tile in the file sample format
+        /// \param tile Tile buffer
+        /// \param pyramidLevel Pyramid level of the tile
+        void convertTile(tdata_t tiffTile, UserType *tile, uint32_t pyramidLevel) {
+
             uint32_t numTilePixels = _tileWidths[pyramidLevel] * _tileHeights[pyramidLevel];
             uint32_t numTileSamples = numTilePixels * _samplesPerPixels[pyramidLevel];
 
@@ -409,9 +495,6 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
                                "format = " << _sampleFormats[pyramidLevel];
                     throw (fi::FastImageException(message.str()));
             }
-
-            _TIFFfree(tiffTile);
-            return diskDuration;
         }
 
         void loadTiffTilesIntoRegion(UserType *region,
@@ -548,6 +631,82 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
         }
 
     private:
+        /// \brief Make a pyramid level the current directory of the tiff file.
+        /// \details Nothing is done if the level is already the current one, so reads at the same level do not parse
+        /// the directory again. Otherwise the directory is read from its cached offset.
+        /// \param pyramidLevel Pyramid level
+        void setLevel(uint32_t pyramidLevel) {
+            if (pyramidLevel == _currentLevel) {
+                return;
+            }
+
+            if (TIFFSetSubDirectory(_tiff, _directoryOffsets[pyramidLevel]) != 1) {
+                std::stringstream message;
+                message
+                        << "Tile Loader ERROR: TIFFSetSubDirectory error in loadTileFromFile with "
+                        << "pyramidLevel = " << pyramidLevel;
+                throw (fi::FastImageException(message.str()));
+            }
+            _currentLevel = pyramidLevel;
+            _counters->directorySwitches++;
+
+            _tileByteCounts = nullptr;
+            TIFFGetField(_tiff, TIFFTAG_TILEBYTECOUNTS, &_tileByteCounts);
+        }
+
+        /// \brief Decode a tile whose compressed bytes are read by the I/O threads
+        /// \details The bytes are copied in a buffer of the loader, libtiff may reverse their bits in place.
+        /// Before libtiff 4.1.0 the tile is read by libtiff, as without I/O threads.
+        /// \param tiffTile Decoded tile buffer
+        /// \param tileSize Size of a decoded tile
+        /// \param indexRowGlobalTile Row index tile asked
+        /// \param indexColGlobalTile Column Index tile asked
+        /// \param pyramidLevel Pyramid level of the tile, the current directory
+        /// \return Number of bytes decoded, -1 if the tile could not be decoded
+        tsize_t decodeRawTile(tdata_t tiffTile, tmsize_t tileSize, uint32_t indexRowGlobalTile,
+                              uint32_t indexColGlobalTile, uint32_t pyramidLevel) {
+#ifdef EGT_RAW_TILE_DECODE
+            auto rawTile = _rawTileReader->get(pyramidLevel, indexRowGlobalTile, indexColGlobalTile);
+            _rawTile.assign(rawTile->begin(), rawTile->end());
+            auto tileIndex = TIFFComputeTile(_tiff, indexColGlobalTile * _tileWidths[pyramidLevel],
+                                             indexRowGlobalTile * _tileHeights[pyramidLevel], 0, 0);
+            if (TIFFReadFromUserBuffer(_tiff, tileIndex, _rawTile.data(), (tmsize_t) _rawTile.size(),
+                                       tiffTile, tileSize) != 1) {
+                return -1;
+            }
+            return tileSize;
+#else
+            (void) tileSize;
+            return TIFFReadTile(_tiff, tiffTile, indexColGlobalTile * _tileWidths[pyramidLevel],
+                                indexRowGlobalTile * _tileHeights[pyramidLevel], 0, 0);
+#endif
+        }
+
+        /// \brief Test if the tiles of a pyramid level are stored as UserType samples, so they need no conversion
+        /// \param pyramidLevel Pyramid level
+        /// \param tileSize Size in bytes of a decoded tile of this level
+        /// \return True if a decoded tile can be used as is
+        bool isUserTypeLayout(uint32_t pyramidLevel, tmsize_t tileSize) const {
+            uint16_t sampleFormat = std::is_floating_point<UserType>::value ? SAMPLEFORMAT_IEEEFP
+                                    : std::is_signed<UserType>::value ? SAMPLEFORMAT_INT : SAMPLEFORMAT_UINT;
+            return _sampleFormats[pyramidLevel] == sampleFormat
+                   && _bitsPerSamples[pyramidLevel] == 8 * sizeof(UserType)
+                   && (uint64_t) tileSize == (uint64_t) _tileWidths[pyramidLevel] * _tileHeights[pyramidLevel]
+                                             * _samplesPerPixels[pyramidLevel] * sizeof(UserType);
+        }
+
+        /// \brief Convert a tile to UserType, recording the conversion time
+        /// \param tiffTile Tile in the file sample format
+        /// \param tile Tile buffer
+        /// \param pyramidLevel Pyramid level of the tile
+        void convertTileAndCount(tdata_t tiffTile, UserType *tile, uint32_t pyramidLevel) {
+            auto begin = std::chrono::high_resolution_clock::now();
+            convertTile(tiffTile, tile, pyramidLevel);
+            auto end = std::chrono::high_resolution_clock::now();
+            _counters->convertDuration += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    end - begin).count();
+        }
+
         /// \brief TiffTileLoader constructor used by the copy operator
         /// \param numThreads Number of thread used by the tiff tile loader
         /// \param filePath File path
@@ -555,8 +714,12 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
         PyramidTiledTiffLoader(size_t numThreads,
                             const std::string &filePath,
                             const PyramidTiledTiffLoader &from)
-                : fi::ATileLoader<UserType>(filePath, numThreads) {
+                : fi::ATileLoader<UserType>(filePath, numThreads), _tileCache(from._tileCache),
+                  _rawTileReader(from._rawTileReader), _counters(from._counters) {
             this->_tiff = TIFFOpen(filePath.c_str(), "r");
+            if (this->_tiff != nullptr) {
+                TIFFGetField(this->_tiff, TIFFTAG_TILEBYTECOUNTS, &_tileByteCounts);
+            }
 
             this->_numPyramidLevels = from._numPyramidLevels;
 
@@ -570,6 +733,7 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
             _samplesPerPixels = new uint16_t[_numPyramidLevels];
             _bitsPerSamples = new uint16_t[_numPyramidLevels];
             _sampleFormats = new uint16_t[_numPyramidLevels];
+            _directoryOffsets = new uint64_t[_numPyramidLevels];
 
             for (uint32_t level = 0; level < this->_numPyramidLevels; level++) {
                 this->_imageWidths[level] = from._imageWidths[level];
@@ -581,11 +745,23 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
                 this->_sampleFormats[level] = from._sampleFormats[level];
                 this->_bitsPerSamples[level] = from._bitsPerSamples[level];
                 this->_samplesPerPixels[level] = from._samplesPerPixels[level];
+                this->_directoryOffsets[level] = from._directoryOffsets[level];
             }
         }
 
         TIFF * _tiff = nullptr;             ///< Tiff file pointer
 
+        std::shared_ptr<TiffTileCache> _tileCache = nullptr;   ///< Decoded tiles shared between loaders
+
+        std::shared_ptr<RawTileReader> _rawTileReader = nullptr;   ///< I/O threads shared between loaders
+
+        std::shared_ptr<TileLoaderCounters> _counters = nullptr;   ///< Tile read statistics shared between loaders
+
+        std::vector<uint8_t> _tiffTile{};      ///< Decode buffer, reused for every tile read from the file
+        std::vector<uint8_t> _rawTile{};       ///< Compressed tile given to libtiff, reused for every tile
+        uint32_t _currentLevel = 0;           ///< Pyramid level of the current tiff directory
+        uint64 * _tileByteCounts = nullptr;   ///< Tile byte counts of the current tiff directory, owned by libtiff
+
         uint32_t * _imageHeights = nullptr;           ///< Image height in pixel
         uint32_t * _imageWidths = nullptr;            ///< Image width in pixel
         uint32_t * _tileHeights = nullptr;            ///< Tile height
@@ -597,6 +773,7 @@ class PyramidTiledTiffLoader : public fi::ATileLoader<UserType> {
         uint16_t * _sampleFormats = nullptr;          ///< Sample format as defined by libtiff
         uint16_t * _bitsPerSamples = nullptr;         ///< Bit Per Sample as defined by libtiff
         uint16_t * _samplesPerPixels = nullptr;       ///< Samples Per Pixel as defined by libtiff
+        uint64_t * _directoryOffsets = nullptr;       ///< File offset of each pyramid level directory
 
     };
 }
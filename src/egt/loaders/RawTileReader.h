@@ -0,0 +1,322 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_RAWTILEREADER_H
+#define NEWEGT_RAWTILEREADER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <tiffio.h>
+#include <FastImage/exception/FastImageException.h>
+
+//Decoding the tiles read by the I/O threads needs TIFFReadFromUserBuffer, which comes with libtiff 4.1.0.
+#if TIFFLIB_VERSION >= 20191103
+#define EGT_RAW_TILE_DECODE
+#endif
+
+namespace egt {
+
+    /**
+     * Read the compressed bytes of the tiles of a tiled tiff on a pool of I/O threads.
+     *
+     * The tile offsets and byte counts of every pyramid level are read once when the file is opened. The I/O threads
+     * then fetch the raw tile bytes with pread, so the tile loaders only decode them and the I/O depth is set
+     * independently from the number of decoding threads.
+     * When a tile is requested, the next tiles of its level in row major order are read ahead, so the I/O threads
+     * keep busy while the loaders decode. Requested tiles are read before the tiles read ahead.
+     * Each tile is read ahead at most once per pass over the image. A tile requested again in the same pass, once
+     * evicted from the loader cache, is read again alone.
+     * The reader is thread safe and shared by all the loaders of the same file.
+     */
+    class RawTileReader {
+
+    public:
+
+        using Tile = std::shared_ptr<const std::vector<uint8_t>>;
+
+        /// \brief RawTileReader constructor
+        /// \param fileName File path
+        /// \param nbIoThreads Number of threads reading the file
+        /// \param readAhead Number of tiles read ahead of the last requested tile
+        RawTileReader(const std::string &fileName, uint32_t nbIoThreads, uint32_t readAhead) :
+                _readAhead(readAhead) {
+            TIFF *tiff = TIFFOpen(fileName.c_str(), "r");
+            if (tiff == nullptr) {
+                throw (fi::FastImageException("Raw Tile Reader ERROR: The image can not be opened."));
+            }
+            do {
+                uint32_t imageWidth = 0, tileWidth = 0;
+                uint64 *offsets = nullptr, *byteCounts = nullptr;
+                TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &imageWidth);
+                TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tileWidth);
+                if (tileWidth == 0 || !TIFFGetField(tiff, TIFFTAG_TILEOFFSETS, &offsets)
+                    || !TIFFGetField(tiff, TIFFTAG_TILEBYTECOUNTS, &byteCounts)) {
+                    TIFFClose(tiff);
+                    throw (fi::FastImageException("Raw Tile Reader ERROR: The image is not tiled."));
+                }
+                auto nbTiles = TIFFNumberOfTiles(tiff);
+                _levels.push_back({(imageWidth + tileWidth - 1) / tileWidth,
+                                   std::vector<uint64_t>(offsets, offsets + nbTiles),
+                                   std::vector<uint64_t>(byteCounts, byteCounts + nbTiles),
+                                   std::vector<TileState>(nbTiles, TileState::NONE), 0});
+            } while (TIFFReadDirectory(tiff));
+            TIFFClose(tiff);
+
+            _fd = open(fileName.c_str(), O_RDONLY);
+            if (_fd < 0) {
+                throw (fi::FastImageException("Raw Tile Reader ERROR: The image can not be opened."));
+            }
+
+            for (uint32_t i = 0; i < std::max(nbIoThreads, (uint32_t) 1); ++i) {
+                _ioThreads.emplace_back(&RawTileReader::readTiles, this);
+            }
+        }
+
+        /// \brief Stop the I/O threads and close the file
+        ~RawTileReader() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _requestCondition.notify_all();
+            for (auto &thread : _ioThreads) {
+                thread.join();
+            }
+            close(_fd);
+        }
+
+        /// \brief Start a new pass over the image, every tile can be read ahead again.
+        /// \details Called when a new loader is built, before its graph requests any tile.
+        void beginPass() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto &tiles : _levels) {
+                std::fill(tiles.states.begin(), tiles.states.end(), TileState::NONE);
+                tiles.nextReadAhead = 0;
+            }
+        }
+
+        /// \brief Get the compressed bytes of a tile, waiting for them to be read.
+        /// \details The tile is forgotten once given to a loader, so each read ahead tile is read once per pass.
+        /// \param level Pyramid level
+        /// \param row Tile row
+        /// \param col Tile col
+        /// \return The compressed tile bytes
+        Tile get(uint32_t level, uint32_t row, uint32_t col) {
+            auto &tiles = _levels.at(level);
+            uint64_t index = (uint64_t) row * tiles.nbTileCols + col;
+            std::shared_ptr<Entry> entry;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                auto found = _entries.find(key(level, index));
+                if (found == _entries.end()) {
+                    //a tile already given to a loader in this pass is only read again, the tiles after it are not
+                    tiles.states[index] = TileState::FETCHED;
+                    entry = std::make_shared<Entry>(level, index);
+                    _entries[key(level, index)] = entry;
+                    _requested.push_back(entry);
+                } else {
+                    entry = found->second;
+                    //a tile read ahead but not read yet is read before the other tiles read ahead
+                    if (!entry->taken) {
+                        _requested.push_back(entry);
+                    }
+                    _hits++;
+                }
+                readAhead(level, index);
+                _readyCondition.wait(lock, [&entry] { return entry->ready; });
+                tiles.states[index] = TileState::CONSUMED;
+                found = _entries.find(key(level, index));
+                if (found != _entries.end() && found->second == entry) {
+                    _entries.erase(found);
+                }
+            }
+
+            if (entry->tile == nullptr) {
+                std::stringstream message;
+                message << "Raw Tile Reader ERROR: can not read tile (" << row << "," << col << ") of level " << level;
+                throw (fi::FastImageException(message.str()));
+            }
+            return entry->tile;
+        }
+
+        /// \brief Get the number of compressed bytes read from the file
+        uint64_t getBytesRead() const { return _bytesRead; }
+
+        /// \brief Get the number of tiles read before a loader requested them
+        uint64_t getHits() const { return _hits; }
+
+    private:
+
+        /// \brief Progress of a tile in the current pass
+        enum class TileState : uint8_t {
+            NONE,       ///< Not read
+            FETCHED,    ///< Read or being read, not given to a loader yet
+            CONSUMED    ///< Given to a loader
+        };
+
+        /// \brief Tile layout of a pyramid level
+        struct Level {
+            uint32_t nbTileCols;                ///< Number of tile columns
+            std::vector<uint64_t> offsets;      ///< File offset of each tile
+            std::vector<uint64_t> byteCounts;   ///< Compressed size of each tile
+            std::vector<TileState> states;      ///< Progress of each tile in the current pass
+            uint64_t nextReadAhead;             ///< Index of the next tile to read ahead
+        };
+
+        /// \brief Tile being read or read
+        struct Entry {
+            Entry(uint32_t level, uint64_t index) : level(level), index(index) {}
+
+            uint32_t level;
+            uint64_t index;
+            Tile tile = nullptr;    ///< Tile bytes, nullptr if the read failed
+            bool taken = false;     ///< True once an I/O thread reads the tile, it may be queued twice
+            bool ready = false;     ///< True once the read is done
+        };
+
+        /// \brief Number of tiles read ahead that are kept until requested
+        size_t readAheadWindow() const {
+            return 4 * (size_t) _readAhead + _ioThreads.size();
+        }
+
+        static uint64_t key(uint32_t level, uint64_t index) {
+            return ((uint64_t) level << (uint32_t) 48) | index;
+        }
+
+        /// \brief Queue the tiles following a requested tile, the mutex being held.
+        /// \details Tiles already read in this pass are skipped, so requests coming out of order from concurrent
+        /// loaders do not read the tiles given to other loaders again.
+        void readAhead(uint32_t level, uint64_t index) {
+            auto &tiles = _levels[level];
+            tiles.nextReadAhead = std::max(tiles.nextReadAhead, index + 1);
+            auto end = std::min(index + 1 + _readAhead, (uint64_t) tiles.offsets.size());
+            for (; tiles.nextReadAhead < end; ++tiles.nextReadAhead) {
+                auto k = key(level, tiles.nextReadAhead);
+                if (tiles.states[tiles.nextReadAhead] == TileState::NONE && _entries.count(k) == 0) {
+                    tiles.states[tiles.nextReadAhead] = TileState::FETCHED;
+                    auto entry = std::make_shared<Entry>(level, tiles.nextReadAhead);
+                    _entries[k] = entry;
+                    _readAheads.push_back(entry);
+                    _readAheadKeys.push_back(k);
+                }
+            }
+            _requestCondition.notify_all();
+
+            // forget the oldest tiles read ahead and never requested
+            while (_entries.size() > readAheadWindow() && !_readAheadKeys.empty()) {
+                auto found = _entries.find(_readAheadKeys.front());
+                if (found != _entries.end()) {
+                    if (!found->second->ready) {
+                        break;
+                    }
+                    //the tile will be read again if a loader requests it
+                    _levels[found->second->level].states[found->second->index] = TileState::NONE;
+                    _entries.erase(found);
+                }
+                _readAheadKeys.pop_front();
+            }
+        }
+
+        /// \brief I/O thread loop, requested tiles first
+        void readTiles() {
+            while (true) {
+                std::shared_ptr<Entry> entry;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _requestCondition.wait(lock, [this] {
+                        return _stop || !_requested.empty() || !_readAheads.empty();
+                    });
+                    if (_stop) {
+                        return;
+                    }
+                    auto &queue = _requested.empty() ? _readAheads : _requested;
+                    entry = queue.front();
+                    queue.pop_front();
+                    if (entry->taken) {
+                        continue;
+                    }
+                    entry->taken = true;
+                }
+
+                auto tile = readTile(entry->level, entry->index);
+
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    entry->tile = tile;
+                    entry->ready = true;
+                }
+                _readyCondition.notify_all();
+            }
+        }
+
+        /// \brief Read the compressed bytes of a tile
+        /// \return The tile bytes, nullptr if the read failed
+        Tile readTile(uint32_t level, uint64_t index) {
+            const auto &tiles = _levels[level];
+            auto bytes = std::make_shared<std::vector<uint8_t>>(tiles.byteCounts[index]);
+            uint64_t done = 0;
+            while (done < bytes->size()) {
+                auto count = pread(_fd, bytes->data() + done, bytes->size() - done,
+                                   (off_t) (tiles.offsets[index] + done));
+                if (count <= 0) {
+                    return nullptr;
+                }
+                done += (uint64_t) count;
+            }
+            _bytesRead += done;
+            return bytes;
+        }
+
+        uint32_t
+                _readAhead = 0;         ///< Number of tiles read ahead of the last requested tile
+
+        int
+                _fd = -1;               ///< File descriptor shared by the I/O threads
+
+        std::vector<Level>
+                _levels{};              ///< Tile layout of each pyramid level
+
+        std::vector<std::thread>
+                _ioThreads{};           ///< I/O threads
+
+        std::mutex
+                _mutex{};               ///< Protects the queues and the entries
+
+        std::condition_variable
+                _requestCondition{},    ///< Signals the I/O threads a tile is queued
+                _readyCondition{};      ///< Signals the loaders a tile is read
+
+        std::deque<std::shared_ptr<Entry>>
+                _requested{},           ///< Tiles requested by the loaders, waiting to be read
+                _readAheads{};          ///< Tiles read ahead, waiting to be read
+
+        std::list<uint64_t>
+                _readAheadKeys{};       ///< Tiles read ahead, oldest first
+
+        std::unordered_map<uint64_t, std::shared_ptr<Entry>>
+                _entries{};             ///< Tiles being read or read, not yet given to a loader
+
+        std::atomic<uint64_t>
+                _bytesRead{0},          ///< Compressed bytes read from the file
+                _hits{0};               ///< Tiles read before being requested
+
+        bool
+                _stop = false;          ///< True when the I/O threads must stop
+    };
+}
+
+#endif //NEWEGT_RAWTILEREADER_H
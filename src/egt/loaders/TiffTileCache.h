@@ -0,0 +1,116 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_TIFFTILECACHE_H
+#define NEWEGT_TIFFTILECACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace egt {
+
+    /**
+     * Cache of decoded tiff tiles shared by all the tile loaders reading the same image.
+     *
+     * Tiles are kept in the file sample format, so loaders of any pixel type can reuse them.
+     * The least recently used tiles are evicted once the memory budget is exceeded.
+     * The cache is thread safe.
+     */
+    class TiffTileCache {
+
+    public:
+
+        using Tile = std::shared_ptr<const std::vector<uint8_t>>;
+
+        /// \brief TiffTileCache constructor
+        /// \param capacity Memory budget in bytes
+        explicit TiffTileCache(uint64_t capacity) : _capacity(capacity) {}
+
+        /// \brief Get a tile from the cache
+        /// \param level Pyramid level
+        /// \param row Tile row
+        /// \param col Tile col
+        /// \return The decoded tile, nullptr if not in the cache
+        Tile get(uint32_t level, uint32_t row, uint32_t col) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto entry = _entries.find(key(level, row, col));
+            if (entry == _entries.end()) {
+                _misses++;
+                return nullptr;
+            }
+            _hits++;
+            //most recently used tiles are at the front
+            _lru.splice(_lru.begin(), _lru, entry->second.position);
+            return entry->second.tile;
+        }
+
+        /// \brief Add a decoded tile to the cache
+        /// \param level Pyramid level
+        /// \param row Tile row
+        /// \param col Tile col
+        /// \param data Decoded tile
+        /// \param size Decoded tile size in bytes
+        void put(uint32_t level, uint32_t row, uint32_t col, const void *data, uint64_t size) {
+            if (size > _capacity) {
+                return;
+            }
+            auto tile = std::make_shared<const std::vector<uint8_t>>((const uint8_t *) data,
+                                                                     (const uint8_t *) data + size);
+            auto k = key(level, row, col);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            //another loader may have decoded the same tile in the meantime
+            if (_entries.count(k) != 0) {
+                return;
+            }
+            while (_size + size > _capacity) {
+                auto &evicted = _entries.at(_lru.back());
+                _size -= evicted.tile->size();
+                _entries.erase(_lru.back());
+                _lru.pop_back();
+            }
+            _lru.push_front(k);
+            _entries[k] = {tile, _lru.begin()};
+            _size += size;
+        }
+
+        /// \return Number of tiles found in the cache
+        uint64_t getHits() const { return _hits; }
+
+        /// \return Number of tiles not found in the cache
+        uint64_t getMisses() const { return _misses; }
+
+    private:
+
+        struct Entry {
+            Tile tile;
+            std::list<uint64_t>::iterator position;
+        };
+
+        static uint64_t key(uint32_t level, uint32_t row, uint32_t col) {
+            return ((uint64_t) level << 48u) | ((uint64_t) row << 24u) | (uint64_t) col;
+        }
+
+        uint64_t
+                _capacity = 0,      ///< Memory budget in bytes
+                _size = 0,          ///< Memory used in bytes
+                _hits = 0,          ///< Number of cache hits
+                _misses = 0;        ///< Number of cache misses
+
+        std::list<uint64_t>
+                _lru{};             ///< Tiles keys, most recently used first
+
+        std::unordered_map<uint64_t, Entry>
+                _entries{};         ///< Cached tiles
+
+        std::mutex
+                _mutex{};
+    };
+}
+
+#endif //NEWEGT_TIFFTILECACHE_H
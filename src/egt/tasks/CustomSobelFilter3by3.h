@@ -10,9 +10,11 @@
 #include <egt/data/ConvOutData.h>
 #include <glog/logging.h>
 #include <egt/utils/Utils.h>
+#include <egt/utils/SobelKernel.h>
 #include <egt/api/DataTypes.h>
 #include <egt/memory/ReleaseMemoryRule.h>
 #include <egt/data/ConvOutMemoryData.h>
+#include <egt/data/IntensityHistogram.h>
 
 namespace egt {
 
@@ -26,12 +28,23 @@ namespace egt {
         uint32_t startRow = 1; //row at which the convolution starts
         uint32_t startCol = 1; //col at which the convolution starts
 
+        std::shared_ptr<IntensityHistogram> intensityHistogram = nullptr; //if set, pixel intensities are also collected
+        std::vector<uint64_t> intensityBins{}; //intensities collected by this task
+
         std::string outputPath = "/home/gerardin/CLionProjects/newEgt/outputs/";
 //        std::string outputPath = "/Users/gerardin/Documents/projects/wipp++/egt/outputs/";
 
     public:
 
-        CustomSobelFilter3by3(size_t numThreads, ImageDepth depth, uint32_t startRow, uint32_t startCol) : htgs::ITask<htgs::MemoryData<fi::View<T>>,ConvOutMemoryData<T>> (numThreads), depth(depth), startRow(startRow), startCol(startCol) {}
+        /// \param intensityHistogram if not null, the pixel intensities of each tile are added to this histogram while computing the gradient.
+        CustomSobelFilter3by3(size_t numThreads, ImageDepth depth, uint32_t startRow, uint32_t startCol,
+                              std::shared_ptr<IntensityHistogram> intensityHistogram = nullptr)
+                : htgs::ITask<htgs::MemoryData<fi::View<T>>,ConvOutMemoryData<T>> (numThreads), depth(depth), startRow(startRow), startCol(startCol),
+                  intensityHistogram(intensityHistogram) {
+            if (intensityHistogram != nullptr) {
+                intensityBins.resize(intensityHistogram->getNbBins(), 0);
+            }
+        }
 
         /// \brief Do the convolution on a view
         /// \param data View
@@ -59,27 +72,19 @@ namespace egt {
             //Emulate Sobel as implemented in ImageJ
             //[description](https://imagejdocu.tudor.lu/faq/technical/what_is_the_algorithm_used_in_find_edges)
             for (auto row = startRow; row < tileHeight + startRow; ++row) {
-                for (auto col = startCol; col < tileWidth + startCol; ++col) {
-                    auto p1 = viewData[(row - 1)*viewWidth + (col - 1)];
-                    auto p2 = viewData[(row - 1)*viewWidth + (col)];
-                    auto p3 =  viewData[(row - 1)*viewWidth + (col + 1)];
-                    auto p4 =  viewData[(row)*viewWidth + (col -1)];
-                    auto p6 =  viewData[(row)*viewWidth + (col +1)];
-                    auto p7 =  viewData[(row +1)*viewWidth + (col - 1)];
-                    auto p8 = viewData[(row + 1)*viewWidth + (col)];
-                    auto p9 =  viewData[(row + 1)*viewWidth + (col + 1)];
-
-                    auto sum1 = p1 + 2*p2 + p3 - p7 - 2*p8 - p9;
-                    auto sum2 = p1  + 2*p4 + p7 - p3 - 2*p6 - p9;
-                    auto sum = sqrt(sum1*sum1 + sum2*sum2);
-
-                    auto index = (row - startCol) * tileWidth + (col - startCol);
-
-                    assert(index < tileWidth * tileHeight);
-                    assert(index >= 0);
-
-                    tileOut[index] = (T)sum;
+                SobelKernel::row(viewData + row * viewWidth + startCol, viewWidth, tileOut + (row - startRow) * tileWidth,
+                                 tileWidth);
+            }
 
+            //collect the tile pixel intensities while the view is still in cache
+            if (intensityHistogram != nullptr) {
+                for (auto row = radius; row < tileHeight + radius; ++row) {
+                    for (auto col = radius; col < tileWidth + radius; ++col) {
+                        auto intensity = (uint64_t) viewData[row * viewWidth + col];
+                        if (intensity < intensityBins.size()) {
+                            intensityBins[intensity]++;
+                        }
+                    }
                 }
             }
 
@@ -99,8 +104,15 @@ namespace egt {
 
         }
 
+        /// \brief Add the intensities collected by this task to the shared histogram
+        void shutdown() override {
+            if (intensityHistogram != nullptr) {
+                intensityHistogram->add(intensityBins);
+            }
+        }
+
         htgs::ITask <htgs::MemoryData<fi::View<T>>, ConvOutMemoryData<T>> *copy() override {
-            return new CustomSobelFilter3by3(this->getNumThreads(), this->depth, this->startRow, this->startCol);
+            return new CustomSobelFilter3by3(this->getNumThreads(), this->depth, this->startRow, this->startCol, this->intensityHistogram);
         }
 
         std::string getName() override { return "Custom Sobel Filter 3 * 3"; }
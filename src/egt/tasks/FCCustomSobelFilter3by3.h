@@ -11,6 +11,7 @@
 #include <egt/data/ConvOutData.h>
 #include <glog/logging.h>
 #include <egt/utils/Utils.h>
+#include <egt/utils/SobelKernel.h>
 #include <egt/api/DataTypes.h>
 #include <egt/memory/ReleaseMemoryRule.h>
 #include <egt/data/ConvOutMemoryData.h>
@@ -27,6 +28,8 @@ namespace egt {
         uint32_t startRow = 1; //row at which the convolution starts
         uint32_t startCol = 1; //col at which the convolution starts
 
+        std::vector<T> rows{}; //original pixels of the rows being convolved
+
         std::string outputPath = "/home/gerardin/CLionProjects/newEgt/outputs/";
 //        std::string outputPath = "/Users/gerardin/Documents/projects/wipp++/egt/outputs/";
 
@@ -58,49 +61,21 @@ namespace egt {
             VLOG(3) << "Custom Sobel Filter for tile (" << view->getRow() << " , " << view->getCol() << ") ..." ;
 
 
-            T* tileOut = new T[viewWidth * viewHeight]();
-
             //Emulate Sobel as implemented in ImageJ
             //[description](https://imagejdocu.tudor.lu/faq/technical/what_is_the_algorithm_used_in_find_edges)
             // IMPORTANT NOTE : viewHeight/viewWidth are always the same, while tileHeight/tileWidth can be different at
             // the borders, so we use tileHeight/tileWidth + 2 * radius to do less work.
-            for (auto row = startRow; row < tileHeight + 2 * radius - startRow; ++row) {
-                for (auto col = startCol; col < tileWidth + 2 * radius - startCol; ++col) {
-                    auto p1 = viewData[(row-1) * viewWidth + (col-1)];
-                    auto p2 = viewData[(row-1) * viewWidth + (col)];
-                    auto p3 =  viewData[(row-1) * viewWidth + (col+1)];
-                    auto p4 =  viewData[(row) * viewWidth + (col - 1)];
-                    auto p6 =  viewData[(row) * viewWidth + (col+1)];
-                    auto p7 =  viewData[(row+1) * viewWidth + (col-1)];
-                    auto p8 = viewData[(row+1) * viewWidth + (col)];
-                    auto p9 =  viewData[(row+1) * viewWidth + (col+1)];
-
-                    auto sum1 = p1 + 2*p2 + p3 - p7 - 2*p8 - p9;
-                    auto sum2 = p1  + 2*p4 + p7 - p3 - 2*p6 - p9;
-                    auto sum = sqrt(sum1*sum1 + sum2*sum2);
-
-                    auto index = row * viewWidth + col;
-
-                    //would be true if we wrote only the tile but we write it inside the whole view
-//                    assert(index >= (tileWidth + 2*radius) * startRow + startCol);
-//                    assert(index <= ((tileWidth + 2*radius) - startRow) * (tileHeight + 2*radius) - startCol );
-                    assert(index >= viewWidth * startRow + startCol);
-                    assert(index <= (viewWidth - startRow) * viewHeight - startCol );
-
-
-                    tileOut[index] = (T)sum;
-
-                }
-            }
-
-            std::copy_n(tileOut, viewHeight * viewWidth, view->getData());
-
-//            auto img5 = cv::Mat(viewHeight, viewWidth, convertToOpencvType(depth), tileOut);
+            // The gradient is written directly in the view.
+            SobelKernel::inPlace(viewData, viewWidth, viewHeight,
+                                 startRow, tileHeight + 2 * radius - startRow,
+                                 startCol, tileWidth + 2 * radius - startCol,
+                                 rows,
+                                 [](uint32_t, const T *) {});
+
+//            auto img5 = cv::Mat(viewHeight, viewWidth, convertToOpencvType(depth), viewData);
 //            cv::imwrite(outputPath + "tileoutcustom" + std::to_string(view->getRow()) + "-" + std::to_string(view->getCol())  + ".png" , img5);
 //            img5.release();
 
-            delete[] tileOut;
-
             // Write the output tile
             this->addResult(data);
         }
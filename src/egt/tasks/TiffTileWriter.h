@@ -5,14 +5,23 @@
 #ifndef NEWEGT_TILETIFFWRITER_H
 #define NEWEGT_TILETIFFWRITER_H
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
 #include <FastImage/api/View.h>
 #include <htgs/api/MemoryData.hpp>
 #include <htgs/api/ITask.hpp>
 #include <htgs/api/VoidData.hpp>
 #include <tiffio.h>
+#include <egt/utils/TiffTileEncoder.h>
 
 namespace egt {
 
+    /// \brief Write the tiles of views to a tiled tiff.
+    /// \details Each thread converts its tiles to the output depth and compresses them in its own buffers. The tiff
+    /// file is shared by all the threads and only the raw tile writes are serialized. Tiles are written in the order
+    /// they arrive, the tile offsets of the tiff locating them.
     template <class UserType>
     class TiffTileWriter : public htgs::ITask<htgs::MemoryData<fi::View<UserType>>, htgs::VoidData> {
 
@@ -24,24 +33,18 @@ namespace egt {
         /// \param tileSize
         /// \param outputDepth The depth of the Output Image.
         /// \param outputPath
-        TiffTileWriter(size_t numThreads,uint32_t imageHeight, uint32_t imageWidth, uint32_t tileSize, ImageDepth outputDepth, std::string outputPath) :
-        _imageHeight(imageHeight), _imageWidth(imageWidth), _tileSize(tileSize), outputDepth(outputDepth), _outputPath(outputPath) {
+        /// \param compression The compression of the tiles, done by the writer before writing them.
+        TiffTileWriter(size_t numThreads,uint32_t imageHeight, uint32_t imageWidth, uint32_t tileSize, ImageDepth outputDepth, std::string outputPath,
+                       MaskCompression compression = MaskCompression::NONE) :
+        TiffTileWriter(numThreads, imageHeight, imageWidth, tileSize, outputDepth, outputPath, compression,
+                       std::make_shared<SharedTiff>(numThreads)) {
             // Create the tiff file
-            tif = TIFFOpen(outputPath.c_str(), "w");
-
-            if (tif != nullptr) {
-                TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, imageWidth);
-                TIFFSetField(tif, TIFFTAG_IMAGELENGTH, imageHeight);
-                TIFFSetField(tif, TIFFTAG_TILELENGTH, tileSize);
-                TIFFSetField(tif, TIFFTAG_TILEWIDTH, tileSize);
-                TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8 * calculateBitsPerSample(outputDepth) );
-                TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, 1);
-                TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
-                TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
-                TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-                TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
-                TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
-                TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+            _tiff->tif = TIFFOpen(outputPath.c_str(), "w");
+
+            if (_tiff->tif != nullptr) {
+                TiffTileEncoder::setTags(_tiff->tif, imageWidth, imageHeight, tileSize, 8 * calculateBitsPerSample(outputDepth),
+                                         compression,
+                                         outputDepth == ImageDepth::_32F ? SAMPLEFORMAT_IEEEFP : SAMPLEFORMAT_UINT);
             }
 
         }
@@ -50,39 +53,86 @@ namespace egt {
 
             fi::View<UserType> *view = data->get();
 
-            auto *tile = new int8_t[_tileSize * _tileSize]();
-
-            for( auto row = 0 ; row < _tileSize ; row++){
-                std::copy_n(view->getPointerTile() + row * view->getViewWidth(), _tileSize, tile + row * _tileSize);
+            switch (outputDepth) {
+                case ImageDepth::_8U:
+                    copyTile<uint8_t>(view);
+                    break;
+                case ImageDepth::_16U:
+                    copyTile<uint16_t>(view);
+                    break;
+                case ImageDepth::_32U:
+                    copyTile<uint32_t>(view);
+                    break;
+                case ImageDepth::_32F:
+                    copyTile<float>(view);
+                    break;
             }
+            auto row = view->getRow(), col = view->getCol();
+            data->releaseMemory();
 
-            TIFFWriteTile(tif,
-                          (tdata_t)tile,
-                          view->getCol() * _tileSize,
-                          view->getRow() * _tileSize,
-                          0,
-                          0);
+            _encoder.encode(_tile.data(), _encoded);
 
-            delete[] tile;
-            data->releaseMemory();
+            {
+                std::lock_guard<std::mutex> lock(_tiff->mutex);
+                TIFFWriteRawTile(_tiff->tif, TIFFComputeTile(_tiff->tif, col * _tileSize, row * _tileSize, 0, 0),
+                                 _encoded.data(), (tmsize_t) _encoded.size());
+            }
         }
 
-        /// \brief Close the tiff file
+        /// \brief Close the tiff file, once every thread is done
         void shutdown() override {
-            TIFFClose(tif);
+            if (--_tiff->nbOpenWriters == 0 && _tiff->tif != nullptr) {
+                TIFFClose(_tiff->tif);
+            }
         }
 
 
         htgs::ITask <htgs::MemoryData<fi::View<UserType>>, htgs::VoidData> *copy() override {
-            return new TiffTileWriter(this->getNumThreads(), _imageHeight, _imageWidth, _tileSize, outputDepth ,_outputPath);
+            return new TiffTileWriter(this->getNumThreads(), _imageHeight, _imageWidth, _tileSize, outputDepth ,_outputPath, _compression, _tiff);
+        }
+
+    private:
+
+        /// \brief Tiff file shared by all the writer threads.
+        struct SharedTiff {
+            explicit SharedTiff(size_t nbWriters) : nbOpenWriters(nbWriters) {}
+
+            TIFF *tif = nullptr;
+            std::mutex mutex{};
+            std::atomic<size_t> nbOpenWriters;
+        };
+
+        TiffTileWriter(size_t numThreads,uint32_t imageHeight, uint32_t imageWidth, uint32_t tileSize, ImageDepth outputDepth, std::string outputPath,
+                       MaskCompression compression, std::shared_ptr<SharedTiff> tiff) :
+        htgs::ITask<htgs::MemoryData<fi::View<UserType>>, htgs::VoidData>(numThreads),
+        _imageHeight(imageHeight), _imageWidth(imageWidth), _tileSize(tileSize), _outputPath(outputPath), outputDepth(outputDepth),
+        _compression(compression), _encoder(tileSize, 8 * calculateBitsPerSample(outputDepth), compression),
+        _tiff(std::move(tiff)) {
+            _tile.resize((size_t) tileSize * tileSize * calculateBitsPerSample(outputDepth));
+        }
+
+        /// \brief Convert the tile pixels to the output depth, the pixels past the image border being 0.
+        template <class OutputType>
+        void copyTile(fi::View<UserType> *view) {
+            auto tile = (OutputType *) _tile.data();
+            std::fill_n(tile, (size_t) _tileSize * _tileSize, 0);
+            for (int32_t row = 0; row < view->getTileHeight(); row++) {
+                const UserType *src = view->getPointerTile() + (size_t) row * view->getViewWidth();
+                std::transform(src, src + view->getTileWidth(), tile + (size_t) row * _tileSize,
+                               [](UserType pixel) { return (OutputType) pixel; });
+            }
         }
 
-        TIFF *tif;
         uint32_t _imageHeight;
         uint32_t _imageWidth;
         uint32_t _tileSize;
         std::string _outputPath;
         ImageDepth outputDepth;
+        MaskCompression _compression;
+        TiffTileEncoder _encoder;
+        std::shared_ptr<SharedTiff> _tiff;
+        std::vector<uint8_t> _tile;      ///< Tile converted to the output depth
+        std::vector<uint8_t> _encoded;   ///< Encoded tile
 
     };
 
@@ -0,0 +1,162 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_PIXELCONVERSION_H
+#define NEWEGT_PIXELCONVERSION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EGT_CONVERSION_X86
+#include <immintrin.h>
+#endif
+
+namespace egt {
+
+    /**
+     * Conversion of arrays of pixels from one type to another, as done by a (Dst) cast of each pixel.
+     *
+     * Same type arrays are copied as is. Widening conversions from 8 and 16 bits unsigned pixels to 16 bits,
+     * 32 bits and float pixels, and truncations of 16 and 32 bits unsigned pixels to 8 and 16 bits, are vectorized
+     * with AVX2 when the cpu supports it, detected once at runtime. Results are bit-identical to the scalar casts.
+     */
+    class PixelConversion {
+
+    public:
+
+        /// \brief Convert an array of pixels.
+        /// \tparam Src Source pixel type
+        /// \tparam Dst Destination pixel type
+        /// \param src Source pixels
+        /// \param dst Destination pixels, must not overlap the source
+        /// \param count Number of pixels
+        template<class Src, class Dst>
+        static void convert(const Src *src, Dst *dst, size_t count) {
+            if constexpr (std::is_same<Src, Dst>::value) {
+                std::copy_n(src, count, dst);
+            } else {
+                size_t done = 0;
+#ifdef EGT_CONVERSION_X86
+                if (hasAVX2()) {
+                    done = convertAVX2(src, dst, count);
+                }
+#endif
+                convertScalar(src + done, dst + done, count - done);
+            }
+        }
+
+        /// \brief Convert an array of pixels, one pixel at a time.
+        template<class Src, class Dst>
+        static void convertScalar(const Src *__restrict src, Dst *__restrict dst, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = (Dst) src[i];
+            }
+        }
+
+    private:
+
+#ifdef EGT_CONVERSION_X86
+
+        static bool hasAVX2() {
+            static const bool avx2 = [] {
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") != 0;
+            }();
+            return avx2;
+        }
+
+        /// \brief No vectorized conversion, everything is left to the scalar loop.
+        template<class Src, class Dst>
+        static size_t convertAVX2(const Src *, Dst *, size_t) {
+            return 0;
+        }
+
+        // Widening, 8 or 16 pixels at a time
+
+        __attribute__((target("avx2")))
+        static size_t convertAVX2(const uint8_t *src, uint16_t *dst, size_t count) {
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                _mm256_storeu_si256((__m256i *) (dst + i),
+                                    _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (src + i))));
+            }
+            return i;
+        }
+
+        __attribute__((target("avx2")))
+        static size_t convertAVX2(const uint8_t *src, uint32_t *dst, size_t count) {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_si256((__m256i *) (dst + i),
+                                    _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (src + i))));
+            }
+            return i;
+        }
+
+        __attribute__((target("avx2")))
+        static size_t convertAVX2(const uint16_t *src, uint32_t *dst, size_t count) {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_si256((__m256i *) (dst + i),
+                                    _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (src + i))));
+            }
+            return i;
+        }
+
+        // 8 and 16 bits integers are exactly represented as floats
+        __attribute__((target("avx2")))
+        static size_t convertAVX2(const uint8_t *src, float *dst, size_t count) {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(
+                        _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (src + i)))));
+            }
+            return i;
+        }
+
+        __attribute__((target("avx2")))
+        static size_t convertAVX2(const uint16_t *src, float *dst, size_t count) {
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(
+                        _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (src + i)))));
+            }
+            return i;
+        }
+
+        // Truncation, 16 pixels at a time. The low bits are kept, so the saturating packs never saturate.
+
+        __attribute__((target("avx2")))
+        static size_t convertAVX2(const uint16_t *src, uint8_t *dst, size_t count) {
+            const __m256i lowBits = _mm256_set1_epi16(0xFF);
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                auto pixels = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (src + i)), lowBits);
+                auto packed = _mm_packus_epi16(_mm256_castsi256_si128(pixels), _mm256_extracti128_si256(pixels, 1));
+                _mm_storeu_si128((__m128i *) (dst + i), packed);
+            }
+            return i;
+        }
+
+        __attribute__((target("avx2")))
+        static size_t convertAVX2(const uint32_t *src, uint16_t *dst, size_t count) {
+            const __m256i lowBits = _mm256_set1_epi32(0xFFFF);
+            size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                auto lo = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (src + i)), lowBits);
+                auto hi = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (src + i + 8)), lowBits);
+                // the pack works within 128 bits lanes, the permutation restores the pixel order
+                auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+                _mm256_storeu_si256((__m256i *) (dst + i), packed);
+            }
+            return i;
+        }
+
+#endif
+    };
+}
+
+#endif //NEWEGT_PIXELCONVERSION_H
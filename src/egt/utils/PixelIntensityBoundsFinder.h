@@ -8,6 +8,7 @@
 #include <egt/api/EGTOptions.h>
 #include <egt/api/SegmentationOptions.h>
 #include <egt/api/DerivedSegmentationParams.h>
+#include <egt/data/IntensityHistogram.h>
 #include <glog/logging.h>
 #include <chrono>
 #include <random>
@@ -41,7 +42,8 @@ namespace egt {
 
                 const uint32_t radiusForThreshold = 0;
 
-                auto tileLoader = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads);
+                auto tileLoader = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads, options->tileCache,
+                                                                options->rawTileReader);
                 auto *fi = new fi::FastImage<T>(tileLoader, radiusForThreshold);
                 fi->getFastImageOptions()->setNumberOfViewParallel(options->concurrentTiles);
                 fi->configureAndRun();
@@ -132,10 +134,8 @@ namespace egt {
             nbOfSamplingExperiment = 1;
         }
 
-        auto minIntensity = minValue;
-        auto maxIntensity = maxValue;
-
-
+        auto minIntensity = std::numeric_limits<T>::max();
+        auto maxIntensity = std::numeric_limits<T>::lowest();
 
         auto expCount = 0;
 
@@ -143,7 +143,8 @@ namespace egt {
 
             const uint32_t radiusForThreshold = 0;
 
-            auto tileLoader = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads);
+            auto tileLoader = new PyramidTiledTiffLoader<T>(options->inputPath, options->nbLoaderThreads, options->tileCache,
+                                                            options->rawTileReader);
             auto *fi = new fi::FastImage<T>(tileLoader, radiusForThreshold);
             fi->getFastImageOptions()->setNumberOfViewParallel(options->concurrentTiles);
             fi->configureAndRun();
@@ -166,7 +167,7 @@ namespace egt {
             VLOG(1) << "Pixel intensity bounds finder. Nb of experiments: " << nbOfSamplingExperiment << std::endl;
 
             //TODO size should not be hardcoded
-            auto intensities = std::vector<T>(256 * 256);
+            auto intensities = std::vector<uint64_t>(NB_INTENSITY_BINS);
 
             if(randomExperiments) {
                 auto seed1 = std::chrono::system_clock::now().time_since_epoch().count();
@@ -188,44 +189,15 @@ namespace egt {
                 auto pview = fi->getAvailableViewBlocking();
                 if(pview != nullptr){
                     auto view = pview->get();
-                    auto tileHeight = view->getTileHeight();
-                    auto tileWidth = view->getTileWidth();
                     VLOG(3) << "intensity bounds : collecting pixel for tile (" << view->getRow() << "," << view->getCol() << ").";
                     binSample(view, intensities);
                     pview->releaseMemory();
                 }
             }
 
-            const double minVal = segmentationOptions->MIN_PIXEL_INTENSITY_PERCENTILE * pixelCount / 100;
-            const double maxVal = segmentationOptions->MAX_PIXEL_INTENSITY_PERCENTILE * pixelCount / 100;
-
-            const T lowerBound = minValue;
-            const T higherBound = maxValue;
-
-            VLOG(3) << "Done. Finding lower and higher bounds between " << (double)lowerBound << " and "<< (double)higherBound << "...";
-
-            auto pixelCount = 0;
-            for(auto k = lowerBound; k <= higherBound; k++){
-                if(pixelCount > minVal) {
-                    minValue = k - 1;
-                    break;
-                }
-                pixelCount += intensities[k];
-            }
-
-            VLOG(3) << "min intensity : " << (double)minValue;
-
-            pixelCount = 0;
-            for(auto l = lowerBound; l <= higherBound; l++){
-                if(pixelCount < maxVal) {
-                    maxValue = l;
-                }
-                pixelCount += intensities[l];
-            }
-
-            VLOG(3) << "max intensity : " << (double)maxValue;
-
-            VLOG(3) << "Done.";
+            findBounds(intensities, segmentationOptions);
+            minIntensity = std::min(minIntensity, minValue);
+            maxIntensity = std::max(maxIntensity, maxValue);
 
             expCount++;
 
@@ -235,34 +207,96 @@ namespace egt {
 
         VLOG(3) << "Done with all sample experiments.";
 
+        segmentationParams.minPixelIntensityValue = minIntensity;
+        segmentationParams.maxPixelIntensityValue = maxIntensity;
+
+        VLOG(1) << "min pixel intensity : " << (double)segmentationParams.minPixelIntensityValue;
+        VLOG(1) << "max pixel intensity : " << (double)segmentationParams.maxPixelIntensityValue;
+
+    }
+
+    /// Derive the pixel intensity bounds from an histogram collected by another pass over the image.
+    /// \param histogram Number of pixels for each intensity value
+    void computePixelIntensityBounds(const IntensityHistogram &histogram, SegmentationOptions* segmentationOptions, DerivedSegmentationParams<T> &segmentationParams) {
+        findBounds(histogram.getBins(), segmentationOptions);
+
         segmentationParams.minPixelIntensityValue = minValue;
         segmentationParams.maxPixelIntensityValue = maxValue;
 
         VLOG(1) << "min pixel intensity : " << (double)segmentationParams.minPixelIntensityValue;
         VLOG(1) << "max pixel intensity : " << (double)segmentationParams.maxPixelIntensityValue;
-
     }
 
-    void binSample(fi::View<T> *data, std::vector<T> &hist){
-        auto sampleSize = data->getTileWidth() * data->getTileHeight();
+    /// Add the pixels of a tile to an histogram of intensities.
+    /// \param data the tile
+    /// \param hist the histogram, one bin per intensity value.
+    static void binSample(fi::View<T> *data, std::vector<uint64_t> &hist){
         for(auto row = 0; row < data->getTileHeight(); row++){
             for(auto col =0; col < data->getTileWidth(); col++){
-                auto index = data->getPixel(row,col);
-                hist[index]++;
-                if(index !=0) {
-                    if (index < minValue) {
-                        minValue = index;
-                    }
-                    if (index > maxValue) {
-                        maxValue = index;
-                    }
-                    pixelCount++;
+                auto index = (uint64_t)data->getPixel(row,col);
+                if(index < hist.size()) {
+                    hist[index]++;
                 }
             }
         }
     }
 
+    /// Number of bins needed to histogram pixel intensities.
+    static const uint64_t NB_INTENSITY_BINS = 256 * 256;
+
     private:
+
+    /// Find the intensities at the requested percentiles of non zero pixels.
+    /// \param intensities Number of pixels for each intensity value
+    void findBounds(const std::vector<uint64_t> &intensities, SegmentationOptions* segmentationOptions) {
+
+        pixelCount = 0;
+        uint64_t lowerBound = intensities.size(), higherBound = 0;
+        for(uint64_t k = 1; k < intensities.size(); k++){
+            if(intensities[k] != 0) {
+                lowerBound = std::min(lowerBound, k);
+                higherBound = k;
+                pixelCount += intensities[k];
+            }
+        }
+
+        if(pixelCount == 0) {
+            VLOG(1) << "no foreground pixel found. Intensity bounds cannot be computed.";
+            return;
+        }
+
+        const double minVal = segmentationOptions->MIN_PIXEL_INTENSITY_PERCENTILE * pixelCount / 100;
+        const double maxVal = segmentationOptions->MAX_PIXEL_INTENSITY_PERCENTILE * pixelCount / 100;
+
+        VLOG(3) << "Done. Finding lower and higher bounds between " << lowerBound << " and "<< higherBound << "...";
+
+        minValue = (T)lowerBound;
+        maxValue = (T)higherBound;
+
+        double count = 0;
+        for(auto k = lowerBound; k <= higherBound; k++){
+            if(count > minVal) {
+                minValue = (T)(k - 1);
+                break;
+            }
+            count += intensities[k];
+        }
+
+        VLOG(3) << "min intensity : " << (double)minValue;
+
+        count = 0;
+        for(auto l = lowerBound; l <= higherBound; l++){
+            if(count < maxVal) {
+                maxValue = (T)l;
+            }
+            count += intensities[l];
+        }
+
+        VLOG(3) << "max intensity : " << (double)maxValue;
+
+        VLOG(3) << "Done.";
+    }
+
         double pixelCount = 0;
         T minValue = std::numeric_limits<T>::max();
         T maxValue = std::numeric_limits<T>::min();
@@ -0,0 +1,248 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_TIFFTILEENCODER_H
+#define NEWEGT_TIFFTILEENCODER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <tiffio.h>
+#include <glog/logging.h>
+#include <egt/api/DataTypes.h>
+
+namespace egt {
+
+    /**
+     * Encode the tiles of a tiled tiff outside of the thread writing the file.
+     *
+     * Each tile is compressed with the libtiff codec through a tiff held in memory, and the compressed bytes are
+     * then written with TIFFWriteRawTile. Several encoders can therefore compress tiles in parallel while a single
+     * thread writes them. An encoder is not thread safe, each thread needs its own instance.
+     *
+     * 1 bit per pixel tiles are given with one byte per pixel, any non zero value being foreground.
+     */
+    class TiffTileEncoder {
+
+    public:
+
+        /// \brief TiffTileEncoder constructor
+        /// \param tileSize Tile size
+        /// \param bitsPerSample Number of bits per pixel, 1 or a multiple of 8
+        /// \param compression Tile compression
+        TiffTileEncoder(uint32_t tileSize, uint16_t bitsPerSample, MaskCompression compression) :
+                _tileSize(tileSize), _bitsPerSample(bitsPerSample), _compression(resolveCompression(compression)) {}
+
+        /// \brief Set the tags of a tiled image directory.
+        /// \details Predictable compressions use horizontal differencing, which suits masks.
+        /// \param tif Tiff file, whose current directory is set
+        /// \param imageWidth Image width
+        /// \param imageHeight Image height
+        /// \param tileSize Tile size
+        /// \param bitsPerSample Number of bits per pixel
+        /// \param compression Tile compression
+        /// \param sampleFormat Format of the pixels
+        static void setTags(TIFF *tif, uint32_t imageWidth, uint32_t imageHeight, uint32_t tileSize,
+                            uint16_t bitsPerSample, MaskCompression compression,
+                            uint16_t sampleFormat = SAMPLEFORMAT_UINT) {
+            compression = resolveCompression(compression);
+            TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, imageWidth);
+            TIFFSetField(tif, TIFFTAG_IMAGELENGTH, imageHeight);
+            TIFFSetField(tif, TIFFTAG_TILELENGTH, tileSize);
+            TIFFSetField(tif, TIFFTAG_TILEWIDTH, tileSize);
+            TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, bitsPerSample);
+            TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+            TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, sampleFormat);
+            TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+            TIFFSetField(tif, TIFFTAG_COMPRESSION, tiffCompression(compression));
+            if (usePredictor(compression, bitsPerSample)) {
+                TIFFSetField(tif, TIFFTAG_PREDICTOR, PREDICTOR_HORIZONTAL);
+            }
+            TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+            TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+        }
+
+        /// \brief Encode a tile.
+        /// \param pixels Tile pixels, stored row by row with a stride of the tile size
+        /// \return Encoded tile, as it is stored in the file
+        std::vector<uint8_t> encode(const void *pixels) {
+            std::vector<uint8_t> encoded;
+            encode(pixels, encoded);
+            return encoded;
+        }
+
+        /// \brief Encode a tile into a buffer, which keeps its capacity from one tile to the next.
+        /// \param pixels Tile pixels, stored row by row with a stride of the tile size
+        /// \param encoded Encoded tile, as it is stored in the file
+        void encode(const void *pixels, std::vector<uint8_t> &encoded) {
+            const uint8_t *samples = static_cast<const uint8_t *>(pixels);
+            auto nbBytes = (size_t) _tileSize * _tileSize * _bitsPerSample / 8;
+            if (_bitsPerSample == 1) {
+                pack(samples);
+                samples = _packed.data();
+                nbBytes = _packed.size();
+            }
+
+            if (_compression == MaskCompression::NONE) {
+                encoded.assign(samples, samples + nbBytes);
+                return;
+            }
+
+            //the codec may modify its input, when applying the predictor
+            _samples.assign(samples, samples + nbBytes);
+            _file.data.clear();
+            _file.position = 0;
+            TIFF *tif = TIFFClientOpen("tile", "w", (thandle_t) &_file, MemoryFile::read, MemoryFile::write,
+                                       MemoryFile::seek, MemoryFile::close, MemoryFile::size,
+                                       MemoryFile::map, MemoryFile::unmap);
+            setTags(tif, _tileSize, _tileSize, _tileSize, _bitsPerSample, _compression);
+            TIFFWriteEncodedTile(tif, 0, _samples.data(), (tmsize_t) nbBytes);
+
+            uint64_t *offsets = nullptr, *byteCounts = nullptr;
+            TIFFGetField(tif, TIFFTAG_TILEOFFSETS, &offsets);
+            TIFFGetField(tif, TIFFTAG_TILEBYTECOUNTS, &byteCounts);
+            encoded.assign(_file.data.begin() + offsets[0], _file.data.begin() + offsets[0] + byteCounts[0]);
+            //the directory of the in memory tiff is never written
+            TIFFCleanup(tif);
+        }
+
+        /// \brief Encode a tile and write it in the current directory of a tiff file.
+        /// \param tif Tiff file
+        /// \param pixels Tile pixels, stored row by row with a stride of the tile size
+        /// \param row Tile row
+        /// \param col Tile col
+        void write(TIFF *tif, const void *pixels, uint32_t row, uint32_t col) {
+            encode(pixels, _encoded);
+            TIFFWriteRawTile(tif, TIFFComputeTile(tif, col * _tileSize, row * _tileSize, 0, 0),
+                             _encoded.data(), (tmsize_t) _encoded.size());
+        }
+
+    private:
+
+        /// \brief Tiff held in memory, only used through the libtiff client procedures.
+        struct MemoryFile {
+            std::vector<uint8_t> data{};
+            uint64_t position = 0;
+
+            static tmsize_t read(thandle_t handle, void *buffer, tmsize_t size) {
+                auto file = (MemoryFile *) handle;
+                auto available = file->position < file->data.size() ? file->data.size() - file->position : 0;
+                auto count = (tmsize_t) std::min((uint64_t) size, (uint64_t) available);
+                std::memcpy(buffer, file->data.data() + file->position, (size_t) count);
+                file->position += count;
+                return count;
+            }
+
+            static tmsize_t write(thandle_t handle, void *buffer, tmsize_t size) {
+                auto file = (MemoryFile *) handle;
+                if (file->position + size > file->data.size()) {
+                    file->data.resize(file->position + size);
+                }
+                std::memcpy(file->data.data() + file->position, buffer, (size_t) size);
+                file->position += size;
+                return size;
+            }
+
+            static toff_t seek(thandle_t handle, toff_t offset, int whence) {
+                auto file = (MemoryFile *) handle;
+                switch (whence) {
+                    case SEEK_SET:
+                        file->position = offset;
+                        break;
+                    case SEEK_CUR:
+                        file->position += offset;
+                        break;
+                    default:
+                        file->position = file->data.size() + offset;
+                        break;
+                }
+                return file->position;
+            }
+
+            static int close(thandle_t) { return 0; }
+
+            static toff_t size(thandle_t handle) { return ((MemoryFile *) handle)->data.size(); }
+
+            static int map(thandle_t, void **, toff_t *) { return 0; }
+
+            static void unmap(thandle_t, void *, toff_t) {}
+        };
+
+        /// \return The compression to use, zstd falling back to deflate when libtiff does not provide it
+        static MaskCompression resolveCompression(MaskCompression compression) {
+            if (compression != MaskCompression::ZSTD) {
+                return compression;
+            }
+#ifdef COMPRESSION_ZSTD
+            //libtiff knows the scheme but may be built without the codec
+            if (TIFFIsCODECConfigured(COMPRESSION_ZSTD)) {
+                return compression;
+            }
+#endif
+            LOG_FIRST_N(WARNING, 1) << "zstd compression is not available in libtiff, using deflate instead.";
+            return MaskCompression::DEFLATE;
+        }
+
+        /// \return The libtiff compression scheme
+        static uint16_t tiffCompression(MaskCompression compression) {
+            switch (compression) {
+                case MaskCompression::DEFLATE:
+                    return COMPRESSION_ADOBE_DEFLATE;
+                case MaskCompression::LZW:
+                    return COMPRESSION_LZW;
+#ifdef COMPRESSION_ZSTD
+                case MaskCompression::ZSTD:
+                    return COMPRESSION_ZSTD;
+#endif
+                case MaskCompression::PACKBITS:
+                    return COMPRESSION_PACKBITS;
+                default:
+                    return COMPRESSION_NONE;
+            }
+        }
+
+        /// \return True if the compression applies the horizontal predictor
+        static bool usePredictor(MaskCompression compression, uint16_t bitsPerSample) {
+            return bitsPerSample >= 8 && (compression == MaskCompression::DEFLATE
+                                          || compression == MaskCompression::LZW
+                                          || compression == MaskCompression::ZSTD);
+        }
+
+        /// \brief Pack one byte per pixel into 1 bit per pixel rows, the first pixel of a byte being its highest bit.
+        void pack(const uint8_t *pixels) {
+            auto rowBytes = (_tileSize + 7) / 8;
+            _packed.assign((size_t) rowBytes * _tileSize, 0);
+            for (uint32_t row = 0; row < _tileSize; ++row) {
+                const uint8_t *src = pixels + (size_t) row * _tileSize;
+                uint8_t *dst = _packed.data() + (size_t) row * rowBytes;
+                for (uint32_t col = 0; col < _tileSize; ++col) {
+                    if (src[col] != 0) {
+                        dst[col >> 3u] |= (uint8_t) (0x80u >> (col & 7u));
+                    }
+                }
+            }
+        }
+
+        uint32_t
+                _tileSize{};            ///< Tile size
+
+        uint16_t
+                _bitsPerSample{};       ///< Number of bits per pixel
+
+        MaskCompression
+                _compression{};         ///< Tile compression
+
+        std::vector<uint8_t>
+                _packed{},              ///< 1 bit per pixel tile
+                _samples{},             ///< Copy of the tile given to the codec
+                _encoded{};             ///< Encoded tile written by write
+
+        MemoryFile
+                _file{};                ///< In memory tiff the codec writes to
+    };
+}
+
+#endif //NEWEGT_TIFFTILEENCODER_H
@@ -0,0 +1,38 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+#ifndef NEWEGT_BENCHMARKUTILS_H
+#define NEWEGT_BENCHMARKUTILS_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+// Helpers shared by the benchmarks comparing a new code path with the former one.
+
+/// \brief Average duration of a function call in microseconds.
+inline double timeCall(const std::function<void()> &f, uint32_t repeat) {
+    auto begin = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < repeat; ++i) {
+        f();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - begin).count() / repeat;
+}
+
+/// \brief End a row of the result table.
+inline void printRow() {
+    std::cout << std::endl;
+}
+
+/// \brief Print a row of the result table, one fixed width column per cell.
+template<class Cell, class... Cells>
+void printRow(const Cell &cell, const Cells &... cells) {
+    std::cout << std::setw(14) << cell;
+    printRow(cells...);
+}
+
+#endif //NEWEGT_BENCHMARKUTILS_H
@@ -0,0 +1,72 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+// Compare the bitmask erosion used by the feature eroder with the former OpenCV path (unpack the bitmask to an array,
+// cv::erode, pack the result back) for several feature sizes.
+// Exit with an error if both erosions do not produce the same bitmask.
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+#include <egt/FeatureCollection/algorithms/bitmaskAlgorithms.h>
+#include "BenchmarkUtils.h"
+
+/// \brief Erode a bitmask the way ListBlobs::erode used to.
+uint32_t *erodeOpenCV(uint32_t *bitMask, uint32_t width, uint32_t height) {
+    const uint8_t foregroundValue = 255;
+    auto data = egt::BitmaskAlgorithms::bitMaskToArray(bitMask, width, height, foregroundValue);
+    auto mat = cv::Mat(height, width, CV_8U, data);
+    auto kernel = cv::getStructuringElement(cv::MORPH_ERODE, cv::Size(3, 3), cv::Point(1, 1));
+    cv::Mat eroded;
+    cv::erode(mat, eroded, kernel);
+    delete[] data;
+    std::vector<uchar> array((uchar *) eroded.datastart, (uchar *) eroded.dataend);
+    return egt::BitmaskAlgorithms::arrayToBitMask(array.data(), width, height, foregroundValue);
+}
+
+int main() {
+    const uint32_t repeat = 10;
+    std::mt19937 generator(42);
+    bool identical = true;
+
+    printRow("feature", "opencv (us)", "bitmask (us)", "speedup");
+
+    for (uint32_t size : {17, 64, 100, 512, 1000, 2048}) {
+        // mostly foreground features, with holes so the erosion has something to do
+        std::bernoulli_distribution foreground(0.95);
+        std::vector<uint8_t> array((size_t) size * size);
+        for (auto &pixel : array) {
+            pixel = foreground(generator) ? 255 : 0;
+        }
+        auto bitMask = egt::BitmaskAlgorithms::arrayToBitMask<uint8_t>(array.data(), size, size, 255);
+        auto nbWords = ((uint64_t) size * size + 31) / 32;
+        std::vector<uint32_t> eroded(nbWords);
+        uint32_t *reference = nullptr;
+
+        auto opencvTime = timeCall([&]() {
+            delete[] reference;
+            reference = erodeOpenCV(bitMask, size, size);
+        }, repeat);
+        auto bitmaskTime = timeCall([&]() {
+            std::fill(eroded.begin(), eroded.end(), 0);
+            egt::BitmaskAlgorithms::erode(bitMask, eroded.data(), size, size, 0, size);
+        }, repeat);
+
+        if (!std::equal(eroded.begin(), eroded.end(), reference)) {
+            std::cout << "erosion mismatch for feature size " << size << std::endl;
+            identical = false;
+        }
+
+        printRow(std::to_string(size) + "x" + std::to_string(size), opencvTime, bitmaskTime,
+                 opencvTime / bitmaskTime);
+
+        delete[] reference;
+        delete[] bitMask;
+    }
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+// Compare the flood fill run by the view analyzers (egt::FloodFill, a flat stack of packed pixel indices, pixels marked
+// as visited when pushed) with the former std::set frontier, on synthetic tiles with a dense foreground.
+// Holes are 4-connected and objects 8-connected, and the former hole filling is replayed between both passes, as in
+// EGTGradientViewAnalyzer.
+// Exit with an error if both frontiers do not find the same blobs.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+#include <egt/FeatureCollection/algorithms/floodFill.h>
+#include "BenchmarkUtils.h"
+
+using Coordinate = std::pair<int32_t, int32_t>;
+
+/// \brief Blob of each pixel, numbered in the order the blobs are found, -1 for the pixels of no blob.
+using Labels = std::vector<int32_t>;
+
+/// \brief Holes smaller than this are filled up before the objects are labeled.
+const uint64_t MIN_HOLE_SIZE = 4;
+
+/// \brief Synthetic tile : random foreground pixels with the given density.
+std::vector<uint8_t> createTile(uint32_t tileSize, double density, std::mt19937 &generator) {
+    std::bernoulli_distribution foreground(density);
+    std::vector<uint8_t> tile(tileSize * tileSize);
+    for (auto &pixel : tile) {
+        pixel = foreground(generator) ? 1 : 0;
+    }
+    return tile;
+}
+
+/// \brief Fill up the last blob found if it is a small hole, and make its pixels visitable again.
+void fillUpSmallHole(std::vector<uint8_t> &tile, std::vector<bool> &visited, Labels &labels,
+                     const std::vector<uint32_t> &blob) {
+    if (blob.size() >= MIN_HOLE_SIZE) {
+        return;
+    }
+    for (auto index : blob) {
+        tile[index] = 1;
+        visited[index] = false;
+        labels[index] = -1;
+    }
+}
+
+/// \brief Label the holes then the objects of a tile with the former std::set frontier, pixels being marked as
+/// visited when popped.
+Labels labelWithSet(std::vector<uint8_t> tile, int32_t tileSize) {
+    std::vector<bool> visited(tile.size(), false);
+    Labels labels(tile.size(), -1);
+    int32_t nbBlobs = 0;
+
+    for (uint8_t color : {0, 1}) {
+        bool eight = (color == 1);
+        std::set<Coordinate> toVisit;
+        for (int32_t row = 0; row < tileSize; ++row) {
+            for (int32_t col = 0; col < tileSize; ++col) {
+                if (visited[row * tileSize + col] || tile[row * tileSize + col] != color) {
+                    continue;
+                }
+                std::vector<uint32_t> blob;
+                toVisit.emplace(row, col);
+                while (!toVisit.empty()) {
+                    auto pixel = *toVisit.begin();
+                    toVisit.erase(toVisit.begin());
+                    auto index = (uint32_t) (pixel.first * tileSize + pixel.second);
+                    visited[index] = true;
+                    labels[index] = nbBlobs;
+                    blob.push_back(index);
+                    for (int32_t rowP = std::max(0, pixel.first - 1); rowP < std::min(tileSize, pixel.first + 2); ++rowP) {
+                        for (int32_t colP = std::max(0, pixel.second - 1); colP < std::min(tileSize, pixel.second + 2); ++colP) {
+                            if (!eight && rowP != pixel.first && colP != pixel.second) {
+                                continue;
+                            }
+                            if (!visited[rowP * tileSize + colP] && tile[rowP * tileSize + colP] == color) {
+                                toVisit.emplace(rowP, colP);
+                            }
+                        }
+                    }
+                }
+                if (color == 0) {
+                    fillUpSmallHole(tile, visited, labels, blob);
+                }
+                nbBlobs++;
+            }
+        }
+    }
+    return labels;
+}
+
+/// \brief Label the holes then the objects of a tile with egt::FloodFill, as the view analyzers do.
+Labels labelWithFloodFill(std::vector<uint8_t> tile, int32_t tileSize, egt::FloodFill &floodFill) {
+    std::vector<bool> visited(tile.size(), false);
+    Labels labels(tile.size(), -1);
+    std::vector<uint32_t> blob;
+    int32_t nbBlobs = 0;
+
+    for (uint8_t color : {0, 1}) {
+        floodFill.fill(tileSize, tileSize, color == 1,
+                       [&](int32_t row, int32_t col) {
+                           return !visited[row * tileSize + col] && tile[row * tileSize + col] == color;
+                       },
+                       [&](int32_t row, int32_t col) { visited[row * tileSize + col] = true; },
+                       [&](int32_t, int32_t) { blob.clear(); },
+                       [&](int32_t row, int32_t col) {
+                           labels[row * tileSize + col] = nbBlobs;
+                           blob.push_back((uint32_t) (row * tileSize + col));
+                       },
+                       [&]() {
+                           if (color == 0) {
+                               fillUpSmallHole(tile, visited, labels, blob);
+                           }
+                           nbBlobs++;
+                       });
+    }
+    return labels;
+}
+
+int main() {
+    const uint32_t repeat = 5;
+    std::mt19937 generator(42);
+    bool identical = true;
+    egt::FloodFill floodFill;
+
+    printRow("tile", "density", "set (us)", "stack (us)", "speedup");
+
+    for (uint32_t tileSize : {256, 512, 1024}) {
+        floodFill.reserve((size_t) tileSize * tileSize);
+        for (double density : {0.7, 0.9, 1.0}) {
+            auto tile = createTile(tileSize, density, generator);
+            Labels setLabels, stackLabels;
+
+            auto setTime = timeCall([&]() { setLabels = labelWithSet(tile, tileSize); }, repeat);
+            auto stackTime = timeCall([&]() { stackLabels = labelWithFloodFill(tile, tileSize, floodFill); }, repeat);
+
+            if (setLabels != stackLabels) {
+                std::cout << "blobs mismatch for tile size " << tileSize << " and density " << density << std::endl;
+                identical = false;
+            }
+
+            printRow(tileSize, density, setTime, stackTime, setTime / stackTime);
+        }
+    }
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+//
+// Created by gerardin on 10/17/26.
+//
+
+// Compare the scalar and vectorized Sobel kernels with the OpenCV Sobel path for several tile sizes.
+// Exit with an error if the vectorized kernel does not produce the same gradient as the scalar one.
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+#include <egt/api/DataTypes.h>
+#include <egt/utils/SobelKernel.h>
+#include "BenchmarkUtils.h"
+
+/// \brief Compute the gradient of a view the way EGTSobelFilter does, with the given instruction set.
+template<class T>
+void sobelView(const T *view, T *out, uint32_t viewWidth, uint32_t viewHeight, egt::SobelKernel::Isa isa) {
+    for (uint32_t row = 1; row < viewHeight - 1; ++row) {
+        egt::SobelKernel::row(view + row * viewWidth + 1, viewWidth, out + row * viewWidth + 1, viewWidth - 2, isa);
+    }
+}
+
+/// \brief Compute the gradient of a view the way SobelFilterOpenCV does.
+void sobelViewOpenCV(cv::Mat &view, cv::Mat &grad, int depth) {
+    cv::Mat grad_x, grad_y;
+    cv::Sobel(view, grad_x, depth, 1, 0, 3, 1, 0, cv::BORDER_DEFAULT);
+    cv::Sobel(view, grad_y, depth, 0, 1, 3, 1, 0, cv::BORDER_DEFAULT);
+    cv::addWeighted(cv::abs(grad_x), 0.5, cv::abs(grad_y), 0.5, 0, grad, CV_32F);
+}
+
+template<class T>
+bool benchmark(const std::string &name, egt::ImageDepth depth) {
+    const uint32_t radius = 1, repeat = 20;
+    std::mt19937 generator(42);
+    bool identical = true;
+
+    std::cout << name << std::endl;
+    printRow("tile", "scalar (us)", "simd (us)", "opencv (us)");
+
+    for (uint32_t tileSize : {64, 128, 256, 512, 1024, 2048}) {
+        uint32_t viewWidth = tileSize + 2 * radius, viewHeight = tileSize + 2 * radius;
+        std::vector<T> view(viewWidth * viewHeight), scalar(view.size()), simd(view.size());
+        for (auto &pixel : view) {
+            pixel = (T) (generator() % 4096);
+        }
+
+        auto scalarTime = timeCall([&]() {
+            sobelView(view.data(), scalar.data(), viewWidth, viewHeight, egt::SobelKernel::Isa::Scalar);
+        }, repeat);
+        auto simdTime = timeCall([&]() {
+            sobelView(view.data(), simd.data(), viewWidth, viewHeight, egt::SobelKernel::getIsa());
+        }, repeat);
+
+        auto mat = cv::Mat(viewHeight, viewWidth, egt::convertToOpencvType(depth), view.data());
+        cv::Mat grad;
+        auto opencvTime = timeCall([&]() { sobelViewOpenCV(mat, grad, egt::convertToOpencvType(depth)); }, repeat);
+
+        if (std::memcmp(scalar.data(), simd.data(), view.size() * sizeof(T)) != 0) {
+            std::cout << "gradient mismatch for tile size " << tileSize << std::endl;
+            identical = false;
+        }
+
+        printRow(tileSize, scalarTime, simdTime, opencvTime);
+    }
+    return identical;
+}
+
+int main() {
+    std::cout << "Sobel kernel instruction set : "
+              << egt::SobelKernel::getIsaName(egt::SobelKernel::getIsa()) << std::endl;
+
+    bool identical = benchmark<uint8_t>("8U", egt::ImageDepth::_8U);
+    identical &= benchmark<uint16_t>("16U", egt::ImageDepth::_16U);
+    identical &= benchmark<float>("32F", egt::ImageDepth::_32F);
+
+    return identical ? 0 : 1;
+}